@@ -4,6 +4,8 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include "Arena.h"
+#include "DictColumn.h"
 
 using namespace std;
 
@@ -20,10 +22,23 @@ struct AVLNode {
 };
 
 class AVLTree {
+private:
+    Arena pool;
+
 public:
     AVLNode *root;
 
-    AVLTree() : root(nullptr) {}
+    AVLTree() : pool(1 << 16), root(nullptr) {}
+
+    AVLTree(const AVLTree &) = delete;
+    AVLTree &operator=(const AVLTree &) = delete;
+
+    void clear() {
+        pool.reset();
+        root = nullptr;
+    }
+
+    ArenaStats memory_stats() { return pool.stats(); }
 
     int getHeight(AVLNode *n) {
         return n ? n->height : 0;
@@ -54,7 +69,7 @@ public:
     }
 
     AVLNode *insert(AVLNode *node, double value, int rowID) {
-        if (!node) return new AVLNode(value, rowID);
+        if (!node) return pool.create<AVLNode>(value, rowID);
 
         if (value < node->value)
             node->left = insert(node->left, value, rowID);
@@ -84,7 +99,7 @@ public:
     void add(double value, int rowID) {
         root = insert(root, value, rowID);
     }
-    void query(AVLNode *node, double minV, double maxV, const vector<vector<string>> &data) {
+    void query(AVLNode *node, double minV, double maxV, const EncodedTable &data) {
         if (!node) return;
 
         if (minV < node->value)
@@ -93,7 +108,7 @@ public:
         if (node->value >= minV && node->value <= maxV) {
             for (int id : node->rowIDs) {
                 cout << "Row " << id << " (" << node->value << "): ";
-                for(const auto& cell : data[id]) cout << cell << " | ";
+                for (size_t j = 0; j < data.width(id); j++) cout << data.cell(id, j) << " | ";
                 cout << endl;
             }
         }
@@ -101,6 +116,25 @@ public:
         if (maxV > node->value)
             query(node->right, minV, maxV, data);
     }
+
+    // Counts rows with values in [minV, maxV] and keeps the first `limit` row IDs in value order.
+    void collect(AVLNode *node, double minV, double maxV, vector<int> &out, size_t limit, size_t &total) const {
+        if (!node) return;
+
+        if (minV < node->value)
+            collect(node->left, minV, maxV, out, limit, total);
+
+        if (node->value >= minV && node->value <= maxV) {
+            total += node->rowIDs.size();
+            for (int id : node->rowIDs) {
+                if (out.size() >= limit) break;
+                out.push_back(id);
+            }
+        }
+
+        if (maxV > node->value)
+            collect(node->right, minV, maxV, out, limit, total);
+    }
 };
 
 #endif
\ No newline at end of file
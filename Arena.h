@@ -0,0 +1,139 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+struct ArenaStats
+{
+    size_t objects;  // live objects handed out since the last reset
+    size_t used;     // bytes handed out
+    size_t reserved; // bytes obtained from the system
+    size_t blocks;
+};
+
+// Bump allocator for node-based structures. Nodes are carved out of large
+// blocks, never freed one by one, and released all together by reset() or the
+// destructor. Destructors of non-trivial node types are remembered and run on
+// release, so members like vector/string inside nodes do not leak.
+class Arena
+{
+private:
+    struct Block
+    {
+        char *mem;
+        size_t size;
+        size_t used;
+    };
+
+    struct Dtor
+    {
+        void (*fn)(void *);
+        void *obj;
+    };
+
+    vector<Block> blocks;
+    vector<Dtor> dtors;
+    size_t nextSize;
+    size_t maxBlock;
+    size_t objects;
+    size_t used;
+
+    template <typename T>
+    static void destroy(void *p) { static_cast<T *>(p)->~T(); }
+
+    void add_block(size_t need)
+    {
+        size_t sz = max(nextSize, need);
+        char *mem = static_cast<char *>(malloc(sz));
+        if (!mem)
+            throw bad_alloc();
+        blocks.push_back({mem, sz, 0});
+        nextSize = min(nextSize * 2, maxBlock);
+    }
+
+    void run_dtors()
+    {
+        for (size_t i = dtors.size(); i-- > 0;)
+            dtors[i].fn(dtors[i].obj);
+        dtors.clear();
+    }
+
+public:
+    Arena(size_t firstBlock = 4096, size_t largestBlock = (size_t)1 << 20)
+        : nextSize(firstBlock), maxBlock(largestBlock), objects(0), used(0) {}
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    ~Arena()
+    {
+        run_dtors();
+        for (Block &b : blocks)
+            free(b.mem);
+    }
+
+    void *allocate(size_t sz, size_t align)
+    {
+        if (blocks.empty())
+            add_block(sz + align);
+        Block *b = &blocks.back();
+        size_t off = (b->used + align - 1) & ~(align - 1);
+        if (off + sz > b->size)
+        {
+            add_block(sz + align);
+            b = &blocks.back();
+            off = (b->used + align - 1) & ~(align - 1);
+        }
+        b->used = off + sz;
+        used += sz;
+        return b->mem + off;
+    }
+
+    template <typename T, typename... Args>
+    T *create(Args &&...args)
+    {
+        T *obj = new (allocate(sizeof(T), alignof(T))) T(forward<Args>(args)...);
+        if (!is_trivially_destructible<T>::value)
+            dtors.push_back({&Arena::destroy<T>, obj});
+        objects++;
+        return obj;
+    }
+
+    // Drops every object at once. The largest block is kept for the next build.
+    void reset()
+    {
+        run_dtors();
+        size_t keep = 0;
+        for (size_t i = 1; i < blocks.size(); i++)
+            if (blocks[i].size > blocks[keep].size)
+                keep = i;
+        for (size_t i = 0; i < blocks.size(); i++)
+            if (i != keep)
+                free(blocks[i].mem);
+        if (!blocks.empty())
+        {
+            Block b = blocks[keep];
+            b.used = 0;
+            blocks.assign(1, b);
+        }
+        objects = 0;
+        used = 0;
+    }
+
+    ArenaStats stats() const
+    {
+        size_t reserved = 0;
+        for (const Block &b : blocks)
+            reserved += b.size;
+        return {objects, used, reserved, blocks.size()};
+    }
+};
+
+#endif
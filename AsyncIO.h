@@ -0,0 +1,445 @@
+#ifndef ASYNCIO_H
+#define ASYNCIO_H
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <istream>
+#include <streambuf>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "BoundedQueue.h"
+#ifdef DSA_USE_URING
+#include <liburing.h>
+#endif
+
+using namespace std;
+
+// Read-ahead / write-behind file I/O in large blocks. Built with
+// -DDSA_USE_URING (and -luring) the requests go through io_uring when the
+// kernel allows it; otherwise a helper thread issues plain read()/write()
+// calls. Either way the caller parses one block while the next is being read,
+// or formats the next buffer while the previous one is being written.
+
+static const size_t IO_BLOCK = 1 << 20; // bytes per request
+static const int IO_DEPTH = 4;          // requests in flight
+
+// Sequential reader that keeps IO_DEPTH aligned blocks in flight ahead of the consumer.
+class AsyncReader
+{
+private:
+    int fd;
+    vector<char *> bufs;
+    vector<size_t> lens;
+    int current;
+    atomic<bool> failed; // also set by the reader thread
+    BoundedQueue<int> freeSlots, fullSlots;
+    thread reader;
+#ifdef DSA_USE_URING
+    io_uring ring;
+    bool ringReady;
+    vector<off_t> offs;
+    vector<char> inflight, done;
+    off_t nextOff, fileSize;
+    int head;
+
+    void submit(int slot)
+    {
+        if (nextOff >= fileSize)
+        {
+            inflight[slot] = 0;
+            return;
+        }
+        io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+        io_uring_prep_read(sqe, fd, bufs[slot], IO_BLOCK, nextOff);
+        io_uring_sqe_set_data64(sqe, slot);
+        offs[slot] = nextOff;
+        lens[slot] = min<off_t>(IO_BLOCK, fileSize - nextOff);
+        nextOff += IO_BLOCK;
+        inflight[slot] = 1;
+        done[slot] = 0;
+    }
+
+    // Waits for the block at `head`; false at the end of the file or on error.
+    bool next_ring(int &slot)
+    {
+        if (failed)
+            return false;
+        if (current >= 0)
+        {
+            submit(current);
+            io_uring_submit(&ring);
+        }
+        slot = head;
+        if (!inflight[slot])
+            return false;
+        while (!done[slot])
+        {
+            io_uring_cqe *cqe = nullptr;
+            if (io_uring_wait_cqe(&ring, &cqe) < 0)
+            {
+                failed = true;
+                return false;
+            }
+            int s = io_uring_cqe_get_data64(cqe);
+            done[s] = 1;
+            if (cqe->res < 0)
+                failed = true;
+            else if ((size_t)cqe->res < lens[s])
+            {
+                // Short read: finish the block synchronously.
+                size_t got = cqe->res;
+                while (got < lens[s])
+                {
+                    ssize_t n = pread(fd, bufs[s] + got, lens[s] - got, offs[s] + got);
+                    if (n < 0)
+                        failed = true;
+                    if (n <= 0)
+                        break;
+                    got += n;
+                }
+                lens[s] = got;
+            }
+            io_uring_cqe_seen(&ring, cqe);
+        }
+        if (failed)
+            return false;
+        head = (head + 1) % IO_DEPTH;
+        return true;
+    }
+#endif
+
+    void read_loop()
+    {
+        int slot;
+        while (freeSlots.pop(slot))
+        {
+            size_t got = 0;
+            while (got < IO_BLOCK)
+            {
+                ssize_t n = ::read(fd, bufs[slot] + got, IO_BLOCK - got);
+                if (n < 0)
+                {
+                    failed = true;
+                    break;
+                }
+                if (n == 0)
+                    break;
+                got += n;
+            }
+            lens[slot] = got;
+            fullSlots.push(slot);
+            if (got < IO_BLOCK)
+                break;
+        }
+        fullSlots.close();
+    }
+
+public:
+    AsyncReader(const string &path)
+        : fd(-1), bufs(IO_DEPTH, nullptr), lens(IO_DEPTH, 0), current(-1), failed(false), freeSlots(IO_DEPTH),
+          fullSlots(IO_DEPTH)
+#ifdef DSA_USE_URING
+          ,
+          ringReady(false), offs(IO_DEPTH), inflight(IO_DEPTH, 0), done(IO_DEPTH, 0), nextOff(0), fileSize(0), head(0)
+#endif
+    {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        for (char *&b : bufs)
+            if (posix_memalign((void **)&b, 4096, IO_BLOCK) != 0)
+            {
+                b = nullptr;
+                ::close(fd);
+                fd = -1;
+                return;
+            }
+#ifdef DSA_USE_URING
+        struct stat st;
+        // The ring reads up to the size known at open, so it is only used for regular,
+        // non-empty files; pipes, /proc files and the case without io_uring (old
+        // kernel, seccomp filter, ...) use the reader thread below, which reads to EOF.
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+            io_uring_queue_init(IO_DEPTH, &ring, 0) == 0)
+        {
+            ringReady = true;
+            fileSize = st.st_size;
+            for (int s = 0; s < IO_DEPTH; s++)
+                submit(s);
+            io_uring_submit(&ring);
+            return;
+        }
+#endif
+        for (int s = 0; s < IO_DEPTH; s++)
+            freeSlots.push(s);
+        reader = thread(&AsyncReader::read_loop, this);
+    }
+
+    AsyncReader(const AsyncReader &) = delete;
+    AsyncReader &operator=(const AsyncReader &) = delete;
+
+    ~AsyncReader()
+    {
+#ifdef DSA_USE_URING
+        if (ringReady)
+        {
+            for (int s = 0; s < IO_DEPTH; s++)
+                while (inflight[s] && !done[s])
+                {
+                    io_uring_cqe *cqe = nullptr;
+                    if (io_uring_wait_cqe(&ring, &cqe) < 0)
+                        break;
+                    done[io_uring_cqe_get_data64(cqe)] = 1;
+                    io_uring_cqe_seen(&ring, cqe);
+                }
+            io_uring_queue_exit(&ring);
+        }
+#endif
+        freeSlots.close();
+        fullSlots.close();
+        if (reader.joinable())
+            reader.join();
+        if (fd >= 0)
+            ::close(fd);
+        for (char *b : bufs)
+            free(b);
+    }
+
+    bool is_open() const { return fd >= 0; }
+
+    // True once a read failed; next() then reports the end of the data early.
+    bool error() const { return failed; }
+
+    // Hands out the next block; the previous one is recycled for read-ahead.
+    bool next(const char *&data, size_t &len)
+    {
+        if (fd < 0)
+            return false;
+        int slot;
+#ifdef DSA_USE_URING
+        if (ringReady)
+        {
+            if (!next_ring(slot))
+                return false;
+        }
+        else
+#endif
+        {
+            if (current >= 0)
+                freeSlots.push(current);
+            if (!fullSlots.pop(slot))
+                return false;
+        }
+        current = slot;
+        data = bufs[slot];
+        len = lens[slot];
+        return len > 0;
+    }
+};
+
+// streambuf over AsyncReader, so istream-based parsers (getline, read_csv_record) read ahead for free.
+class AsyncReadBuf : public streambuf
+{
+private:
+    AsyncReader reader;
+
+protected:
+    int_type underflow() override
+    {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+        const char *data;
+        size_t len;
+        if (!reader.next(data, len))
+            return traits_type::eof();
+        char *p = const_cast<char *>(data);
+        setg(p, p, p + len);
+        return traits_type::to_int_type(*p);
+    }
+
+public:
+    AsyncReadBuf(const string &path) : reader(path) {}
+    bool is_open() const { return reader.is_open(); }
+    bool error() const { return reader.error(); }
+};
+
+// Drop-in replacement for ifstream when reading a file front to back.
+class PrefetchStream : public istream
+{
+private:
+    AsyncReadBuf buf;
+
+public:
+    PrefetchStream(const string &path) : istream(nullptr), buf(path)
+    {
+        rdbuf(&buf);
+        if (!buf.is_open())
+            setstate(ios::failbit);
+    }
+
+    bool is_open() const { return buf.is_open(); }
+
+    // A failed read ends the stream like end-of-file does; check this after reading.
+    bool error() const { return buf.error(); }
+};
+
+// Write-behind file writer. write() takes ownership of the buffer and returns
+// as soon as it is queued; at most IO_DEPTH buffers are outstanding, which
+// bounds memory and blocks a producer that outruns the disk.
+class AsyncWriter
+{
+private:
+    int fd;
+    size_t written;
+    atomic<bool> failed; // also set by the writer thread
+    BoundedQueue<string> pending;
+    thread writer;
+#ifdef DSA_USE_URING
+    io_uring ring;
+    bool ringReady;
+    vector<string> slots;
+    vector<off_t> offs;
+    vector<char> busy;
+    off_t nextOff;
+    int inflight;
+
+    void reap_one()
+    {
+        io_uring_cqe *cqe = nullptr;
+        if (io_uring_wait_cqe(&ring, &cqe) < 0)
+        {
+            failed = true;
+            inflight = 0;
+            return;
+        }
+        int s = io_uring_cqe_get_data64(cqe);
+        size_t got = cqe->res < 0 ? 0 : cqe->res;
+        if (cqe->res < 0)
+            failed = true;
+        // Short write: finish the buffer synchronously.
+        while (!failed && got < slots[s].size())
+        {
+            ssize_t n = pwrite(fd, slots[s].data() + got, slots[s].size() - got, offs[s] + got);
+            if (n <= 0)
+                failed = true;
+            else
+                got += n;
+        }
+        written += got;
+        io_uring_cqe_seen(&ring, cqe);
+        string().swap(slots[s]);
+        busy[s] = 0;
+        inflight--;
+    }
+
+    void write_ring(string &&buf)
+    {
+        if (inflight == IO_DEPTH)
+            reap_one();
+        int s = 0;
+        while (busy[s])
+            s++;
+        slots[s] = move(buf);
+        busy[s] = 1;
+        offs[s] = nextOff;
+        nextOff += slots[s].size();
+        io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+        io_uring_prep_write(sqe, fd, slots[s].data(), slots[s].size(), offs[s]);
+        io_uring_sqe_set_data64(sqe, s);
+        io_uring_submit(&ring);
+        inflight++;
+    }
+#endif
+
+    void write_loop()
+    {
+        string buf;
+        while (pending.pop(buf))
+        {
+            size_t off = 0;
+            while (!failed && off < buf.size())
+            {
+                ssize_t n = ::write(fd, buf.data() + off, buf.size() - off);
+                if (n <= 0)
+                    failed = true;
+                else
+                    off += n;
+            }
+            written += off;
+        }
+    }
+
+public:
+    AsyncWriter(const string &path)
+        : fd(-1), written(0), failed(false), pending(IO_DEPTH)
+#ifdef DSA_USE_URING
+          ,
+          ringReady(false), slots(IO_DEPTH), offs(IO_DEPTH), busy(IO_DEPTH, 0), nextOff(0), inflight(0)
+#endif
+    {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            return;
+#ifdef DSA_USE_URING
+        // Without io_uring the writer thread below is used instead.
+        ringReady = io_uring_queue_init(IO_DEPTH, &ring, 0) == 0;
+        if (ringReady)
+            return;
+#endif
+        writer = thread(&AsyncWriter::write_loop, this);
+    }
+
+    AsyncWriter(const AsyncWriter &) = delete;
+    AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+    ~AsyncWriter() { close(); }
+
+    bool is_open() const { return fd >= 0; }
+
+    void write(string &&buf)
+    {
+        if (fd < 0 || buf.empty())
+            return;
+#ifdef DSA_USE_URING
+        if (ringReady)
+        {
+            write_ring(move(buf));
+            return;
+        }
+#endif
+        pending.push(move(buf));
+    }
+
+    // Waits for every queued buffer; false if any write failed.
+    bool close()
+    {
+        if (fd < 0)
+            return !failed;
+#ifdef DSA_USE_URING
+        if (ringReady)
+        {
+            while (inflight > 0)
+                reap_one();
+            io_uring_queue_exit(&ring);
+            ringReady = false;
+        }
+#endif
+        pending.close();
+        if (writer.joinable())
+            writer.join();
+        ::close(fd);
+        fd = -1;
+        return !failed;
+    }
+
+    // Bytes that reached the file; exact once close() has returned.
+    size_t bytes() const { return written; }
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// Fixed-capacity blocking queue used to connect pipeline stages.
+// push() blocks while the queue is full, which is what gives backpressure:
+// a fast producer can never run more than `cap` items ahead of its consumer.
+template <typename T>
+class BoundedQueue
+{
+private:
+    queue<T> q;
+    size_t cap;
+    bool closed;
+    mutex m;
+    condition_variable notFull, notEmpty;
+
+public:
+    BoundedQueue(size_t capacity) : cap(capacity), closed(false) {}
+
+    void push(T item)
+    {
+        unique_lock<mutex> lock(m);
+        notFull.wait(lock, [&]() { return q.size() < cap || closed; });
+        q.push(move(item));
+        notEmpty.notify_one();
+    }
+
+    // Returns false once the queue is closed and drained.
+    bool pop(T &out)
+    {
+        unique_lock<mutex> lock(m);
+        notEmpty.wait(lock, [&]() { return !q.empty() || closed; });
+        if (q.empty())
+            return false;
+        out = move(q.front());
+        q.pop();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        lock_guard<mutex> lock(m);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+};
+
+#endif
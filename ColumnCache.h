@@ -0,0 +1,299 @@
+#ifndef COLUMNCACHE_H
+#define COLUMNCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include "NumParse.h"
+#include "Sketch.h"
+#include "AVL.h"
+#include "SegmentTree.h"
+#include "DictColumn.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+using namespace std;
+
+// Numeric cells of one column and the rows they came from, in row order.
+struct NumericColumn
+{
+    vector<double> values;
+    vector<int> rows;
+};
+
+// Fills `nc` from column j. Numbers still stored as such in the table's source
+// (a snapshot) are taken as they are; otherwise each distinct value is parsed
+// once and rows only index the result by code.
+inline void numeric_cells(const EncodedTable &data, int j, NumericColumn &nc)
+{
+    nc.values.clear();
+    nc.rows.clear();
+    const double *vals;
+    const uint8_t *nulls;
+    if (data.source_numbers(j, vals, nulls))
+    {
+        for (size_t i = 0; i < data.size(); i++)
+            if (!((nulls[i >> 3] >> (i & 7)) & 1))
+            {
+                nc.values.push_back(vals[i]);
+                nc.rows.push_back((int)i);
+            }
+        return;
+    }
+    const EncodedColumn &col = data.column(j);
+    vector<ParsedNum> parsed(col.dict.size());
+    for (uint32_t c = 0; c < col.dict.size(); c++)
+        parsed[c] = parse_number(col.dict.decode(c));
+    for (int i = 0; i < (int)data.size(); i++)
+        if (parsed[col.codes[i]].ok())
+        {
+            nc.values.push_back(parsed[col.codes[i]].value);
+            nc.rows.push_back(i);
+        }
+}
+
+// Derived data for each column of the working table: parsed numbers, summary
+// stats, column profiles, the ordered (AVL) index and pairwise correlations. Every
+// column carries a version that edits bump; an item is reused while it was
+// built from the column's current version and rebuilt on the next request
+// otherwise, so an edit only costs the columns it touched.
+class ColumnCache
+{
+private:
+    struct Entry
+    {
+        uint64_t id = 0;      // stable across column removals
+        uint64_t version = 0; // changes on every edit of the column
+        uint64_t numericAt = 0, statsAt = 0, sketchAt = 0, orderedAt = 0;
+        NumericColumn numeric;
+        Node stats;
+        ColumnSketch sketch;
+        unique_ptr<AVLTree> ordered;
+    };
+
+    struct CorrEntry
+    {
+        uint64_t va, vb;
+        double r;
+    };
+
+    vector<Entry> cols;
+    map<pair<uint64_t, uint64_t>, CorrEntry> corr; // keyed by column ids, smaller id first
+    uint64_t counter;
+
+    uint64_t next() { return ++counter; }
+
+    void build_numeric(const EncodedTable &data, int j)
+    {
+        numeric_cells(data, j, cols[j].numeric);
+        cols[j].numericAt = cols[j].version;
+    }
+
+    // Stale columns are profiled in parallel, one task per column. Rows are
+    // counted per code, so distinct and top-value counts are exact.
+    void build_sketches(const EncodedTable &data)
+    {
+        vector<int> stale;
+        for (int j = 0; j < (int)cols.size(); j++)
+            if (cols[j].sketchAt != cols[j].version)
+                stale.push_back(j);
+        if (stale.empty())
+            return;
+        PROF_SCOPE("build_sketches");
+        parallel_for(0, stale.size(), 1, [&](size_t k, size_t) {
+            Entry &e = cols[stale[k]];
+            const EncodedColumn &col = data.column(stale[k]);
+            vector<long long> count(col.dict.size(), 0);
+            for (uint32_t c : col.codes)
+                count[c]++;
+            ColumnSketch &sk = e.sketch;
+            sk = ColumnSketch();
+            sk.rows = col.codes.size();
+            vector<uint32_t> order;
+            for (uint32_t c = 0; c < col.dict.size(); c++)
+            {
+                if (count[c] == 0)
+                    continue;
+                if (ColumnSketch::is_null(col.dict.decode(c)))
+                    sk.nulls += count[c];
+                else
+                    order.push_back(c);
+            }
+            sk.distinct = order.size();
+            size_t n = min(order.size(), ColumnSketch::TOP);
+            partial_sort(order.begin(), order.begin() + n, order.end(),
+                         [&](uint32_t a, uint32_t b) { return count[a] != count[b] ? count[a] > count[b] : a < b; });
+            for (size_t r = 0; r < n; r++)
+                sk.top.push_back({string(col.dict.decode(order[r])), count[order[r]]});
+            e.sketchAt = e.version;
+        });
+    }
+
+public:
+    ColumnCache() : counter(0) {}
+
+    ColumnCache(const ColumnCache &) = delete;
+    ColumnCache &operator=(const ColumnCache &) = delete;
+
+    // Forgets everything; call after loading a table or reshaping it.
+    void reset(size_t ncols)
+    {
+        cols.clear();
+        cols.resize(ncols);
+        for (Entry &e : cols)
+        {
+            e.id = next();
+            e.version = next();
+        }
+        corr.clear();
+    }
+
+    size_t columns() const { return cols.size(); }
+
+    // The column's cells changed in place.
+    void bump(int j) { cols[j].version = next(); }
+
+    // Rows were reordered or edited across the table.
+    void bump_all()
+    {
+        for (int j = 0; j < (int)cols.size(); j++)
+            bump(j);
+    }
+
+    void erase_column(int j)
+    {
+        uint64_t id = cols[j].id;
+        for (auto it = corr.begin(); it != corr.end();)
+        {
+            if (it->first.first == id || it->first.second == id)
+                it = corr.erase(it);
+            else
+                ++it;
+        }
+        cols.erase(cols.begin() + j);
+    }
+
+    // Mirrors compact_rows(). Every column gets a new version, but the parsed
+    // numbers are compacted rather than rebuilt.
+    void remove_rows(const vector<bool> &drop)
+    {
+        vector<int> newRow(drop.size(), -1);
+        int w = 0;
+        for (size_t i = 0; i < drop.size(); i++)
+            if (!drop[i])
+                newRow[i] = w++;
+        for (Entry &e : cols)
+        {
+            bool numFresh = e.numericAt == e.version;
+            e.version = next();
+            if (numFresh)
+            {
+                NumericColumn &nc = e.numeric;
+                size_t k = 0;
+                for (size_t p = 0; p < nc.rows.size(); p++)
+                    if (newRow[nc.rows[p]] >= 0)
+                    {
+                        nc.values[k] = nc.values[p];
+                        nc.rows[k++] = newRow[nc.rows[p]];
+                    }
+                nc.values.resize(k);
+                nc.rows.resize(k);
+                e.numericAt = e.version;
+            }
+        }
+    }
+
+    const NumericColumn &numeric(const EncodedTable &data, int j)
+    {
+        if (cols[j].numericAt != cols[j].version)
+            build_numeric(data, j);
+        return cols[j].numeric;
+    }
+
+    // Parses the stale columns among `which` in parallel, one task per column.
+    void prepare_numeric(const EncodedTable &data, const vector<int> &which)
+    {
+        vector<int> stale;
+        for (int j : which)
+            if (cols[j].numericAt != cols[j].version)
+                stale.push_back(j);
+        parallel_for(0, stale.size(), 1, [&](size_t k, size_t) { build_numeric(data, stale[k]); });
+    }
+
+    const Node &stats(const EncodedTable &data, int j)
+    {
+        Entry &e = cols[j];
+        if (e.statsAt != e.version)
+        {
+            SegmentTree st(numeric(data, j).values);
+            e.stats = e.numeric.values.empty() ? Node() : st.getFullStats();
+            e.statsAt = e.version;
+        }
+        return e.stats;
+    }
+
+    const ColumnSketch &sketch(const EncodedTable &data, int j)
+    {
+        if (cols[j].sketchAt != cols[j].version)
+            build_sketches(data);
+        return cols[j].sketch;
+    }
+
+    AVLTree &ordered(const EncodedTable &data, int j)
+    {
+        Entry &e = cols[j];
+        if (e.orderedAt != e.version || !e.ordered)
+        {
+            const NumericColumn &nc = numeric(data, j);
+            if (!e.ordered)
+                e.ordered.reset(new AVLTree());
+            e.ordered->clear();
+            for (size_t k = 0; k < nc.values.size(); k++)
+                e.ordered->add(nc.values[k], nc.rows[k]);
+            e.orderedAt = e.version;
+        }
+        return *e.ordered;
+    }
+
+    // Rows where both columns are numeric, as parallel x/y vectors.
+    void numeric_pairs(const EncodedTable &data, int a, int b, vector<double> &vx, vector<double> &vy)
+    {
+        const NumericColumn &na = numeric(data, a), &nb = numeric(data, b);
+        size_t p = 0, q = 0;
+        while (p < na.rows.size() && q < nb.rows.size())
+        {
+            if (na.rows[p] < nb.rows[q])
+                p++;
+            else if (nb.rows[q] < na.rows[p])
+                q++;
+            else
+            {
+                vx.push_back(na.values[p++]);
+                vy.push_back(nb.values[q++]);
+            }
+        }
+    }
+
+    bool cached_correlation(int a, int b, double &r) const
+    {
+        if (cols[a].id > cols[b].id)
+            swap(a, b);
+        auto it = corr.find({cols[a].id, cols[b].id});
+        if (it == corr.end() || it->second.va != cols[a].version || it->second.vb != cols[b].version)
+            return false;
+        r = it->second.r;
+        return true;
+    }
+
+    void store_correlation(int a, int b, double r)
+    {
+        if (cols[a].id > cols[b].id)
+            swap(a, b);
+        corr[{cols[a].id, cols[b].id}] = {cols[a].version, cols[b].version, r};
+    }
+};
+
+#endif
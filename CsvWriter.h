@@ -0,0 +1,223 @@
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include "ThreadPool.h"
+#include "AsyncIO.h"
+#include "DictColumn.h"
+#ifdef DSA_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace std;
+
+// Formats rows into large buffers on the thread pool, then writes the buffers
+// in order with one big write each. Plain files go through AsyncWriter, so the
+// next round of chunks is formatted while the previous one is being written. Fields are quoted per RFC 4180.
+// Filenames ending in ".gz" are gzip-compressed when built with -DDSA_WITH_ZLIB;
+// zstd is not offered, as the project does not depend on libzstd.
+class CsvWriter
+{
+private:
+    unique_ptr<AsyncWriter> out;
+#ifdef DSA_WITH_ZLIB
+    gzFile gz;
+#endif
+    bool compress;
+    bool failed; // a write came up short
+    size_t bytes;
+    int workers;
+    int chunkRows;
+
+    static bool ends_with(const string &s, const string &suffix)
+    {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    void put(string &&buf)
+    {
+        if (buf.empty())
+            return;
+#ifdef DSA_WITH_ZLIB
+        if (compress)
+        {
+            if (!gz || gzwrite(gz, buf.data(), (unsigned)buf.size()) != (int)buf.size())
+                failed = true;
+            else
+                bytes += buf.size();
+            return;
+        }
+#endif
+        if (out)
+            out->write(move(buf));
+        else
+            failed = true;
+    }
+
+    static size_t row_bytes(const vector<vector<string>> &rows, size_t i)
+    {
+        size_t n = 0;
+        for (const string &c : rows[i])
+            n += c.size() + 1;
+        return n;
+    }
+
+    static size_t row_bytes(const EncodedTable &rows, size_t i)
+    {
+        size_t n = 0;
+        for (size_t j = 0; j < rows.width(i); j++)
+            n += rows.cell(i, j).size() + 1;
+        return n;
+    }
+
+    static void append_row(string &out, const vector<vector<string>> &rows, size_t i) { append_row(out, rows[i]); }
+
+    // Cells are decoded straight into the output buffer.
+    static void append_row(string &out, const EncodedTable &rows, size_t i)
+    {
+        for (size_t j = 0; j < rows.width(i); j++)
+        {
+            if (j)
+                out += ',';
+            append_field(out, rows.cell(i, j));
+        }
+        out += '\n';
+    }
+
+    template <typename Rows>
+    void format_range(const Rows &rows, size_t from, size_t to, string &out)
+    {
+        size_t guess = 0;
+        for (size_t i = from; i < to && i < from + 64; i++)
+            guess += row_bytes(rows, i);
+        if (to - from > 64)
+            guess = guess / 64 * (to - from);
+        out.reserve(guess + guess / 8 + 16);
+        for (size_t i = from; i < to; i++)
+            append_row(out, rows, i);
+    }
+
+public:
+    CsvWriter(string filename, int threads = 0, int rowsPerChunk = 65536)
+        : compress(false), failed(false), bytes(0), chunkRows(rowsPerChunk)
+    {
+        workers = threads > 0 ? threads : ThreadPool::global().size();
+#ifdef DSA_WITH_ZLIB
+        gz = nullptr;
+        if (ends_with(filename, ".gz"))
+        {
+            compress = true;
+            gz = gzopen(filename.c_str(), "wb6");
+            if (gz)
+                gzbuffer(gz, 1 << 20);
+            return;
+        }
+#endif
+        out.reset(new AsyncWriter(filename));
+        if (!out->is_open())
+            out.reset();
+    }
+
+    ~CsvWriter() { close(); }
+
+    bool is_open()
+    {
+#ifdef DSA_WITH_ZLIB
+        if (compress)
+            return gz != nullptr;
+#endif
+        return out != nullptr;
+    }
+
+    static bool needs_quotes(string_view cell)
+    {
+        for (char c : cell)
+            if (c == ',' || c == '"' || c == '\n' || c == '\r')
+                return true;
+        return false;
+    }
+
+    static void append_field(string &out, string_view cell)
+    {
+        if (!needs_quotes(cell))
+        {
+            out += cell;
+            return;
+        }
+        out += '"';
+        for (char c : cell)
+        {
+            if (c == '"')
+                out += '"';
+            out += c;
+        }
+        out += '"';
+    }
+
+    static void append_row(string &out, const vector<string> &row)
+    {
+        for (size_t i = 0; i < row.size(); i++)
+        {
+            if (i)
+                out += ',';
+            append_field(out, row[i]);
+        }
+        out += '\n';
+    }
+
+    void write_row(const vector<string> &row)
+    {
+        string buf;
+        append_row(buf, row);
+        put(move(buf));
+    }
+
+    // Rows are cut into chunks; each round formats one chunk per worker in
+    // parallel and then flushes the finished buffers in row order. `rows` is a
+    // vector of string rows or an EncodedTable.
+    template <typename Rows>
+    void write_rows(const Rows &rows)
+    {
+        size_t n = rows.size();
+        size_t chunks = (n + chunkRows - 1) / chunkRows;
+        vector<string> bufs(workers);
+        for (size_t base = 0; base < chunks; base += workers)
+        {
+            int active = (int)min((size_t)workers, chunks - base);
+            parallel_for(0, active, 1, [&](size_t t, size_t) {
+                size_t from = (base + t) * chunkRows;
+                format_range(rows, from, min(n, from + chunkRows), bufs[t]);
+            });
+            for (int t = 0; t < active; t++)
+            {
+                put(move(bufs[t]));
+                bufs[t] = string();
+            }
+        }
+    }
+
+    // Exact once close() has returned.
+    size_t bytes_written() { return out ? out->bytes() : bytes; }
+
+    // Flushes everything; false if any write failed or came up short.
+    bool close()
+    {
+#ifdef DSA_WITH_ZLIB
+        if (gz)
+        {
+            if (gzclose(gz) != Z_OK)
+                failed = true;
+            gz = nullptr;
+        }
+#endif
+        if (out && !out->close())
+            failed = true;
+        return !failed;
+    }
+};
+
+#endif
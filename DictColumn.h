@@ -0,0 +1,440 @@
+#ifndef DICTCOLUMN_H
+#define DICTCOLUMN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <string_view>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "Sketch.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Per-column string dictionary: each distinct value gets a dense 32-bit code.
+// Values are packed into one character pool and indexed by an open-addressing
+// table of codes, so encoding a column does no per-value allocation.
+// A dictionary can also borrow read-only entries (a snapshot's, in place);
+// it is copied into its own pool the first time a value is encoded.
+class ColumnDictionary
+{
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+    vector<char> pool;
+    vector<uint32_t> offsets; // value c is pool[offsets[c], offsets[c + 1])
+    vector<uint64_t> hashes;
+    vector<uint32_t> slots;
+    size_t mask;
+    const uint64_t *extOffsets; // borrowed: value c is extPool[extOffsets[c], extOffsets[c + 1])
+    const char *extPool;
+    size_t extSize;
+    shared_ptr<const void> keep; // holds the borrowed memory alive
+
+    // Appends a value under the next code, even if it repeats an earlier one.
+    void append(string_view s)
+    {
+        uint64_t h = hash64(s);
+        size_t p = find_slot(s, h);
+        if (slots[p] == EMPTY)
+            slots[p] = size();
+        hashes.push_back(h);
+        pool.insert(pool.end(), s.begin(), s.end());
+        offsets.push_back(pool.size());
+        if (size() * 2 > slots.size())
+            grow();
+    }
+
+    void own()
+    {
+        if (!extPool)
+            return;
+        const uint64_t *offs = extOffsets;
+        const char *src = extPool;
+        size_t n = extSize;
+        shared_ptr<const void> hold = move(keep);
+        extOffsets = nullptr;
+        extPool = nullptr;
+        extSize = 0;
+        pool.reserve(offs[n]);
+        for (size_t c = 0; c < n; c++)
+            append(string_view(src + offs[c], offs[c + 1] - offs[c]));
+    }
+
+    size_t find_slot(string_view s, uint64_t h) const
+    {
+        size_t p = h & mask;
+        while (slots[p] != EMPTY && !(hashes[slots[p]] == h && decode(slots[p]) == s))
+            p = (p + 1) & mask;
+        return p;
+    }
+
+    void grow()
+    {
+        slots.assign(slots.size() * 2, EMPTY);
+        mask = slots.size() - 1;
+        for (uint32_t c = 0; c < size(); c++)
+        {
+            size_t p = hashes[c] & mask;
+            while (slots[p] != EMPTY)
+                p = (p + 1) & mask;
+            slots[p] = c;
+        }
+    }
+
+public:
+    ColumnDictionary() : offsets(1, 0), slots(64, EMPTY), mask(63), extOffsets(nullptr), extPool(nullptr), extSize(0)
+    {
+    }
+
+    // Uses `n` entries laid out like the pool (offsets[n + 1] into `values`)
+    // without copying them; `owner` keeps that memory mapped.
+    void borrow(const uint64_t *offs, const char *values, size_t n, shared_ptr<const void> owner)
+    {
+        *this = ColumnDictionary();
+        extOffsets = offs;
+        extPool = values;
+        extSize = n;
+        keep = move(owner);
+    }
+
+    uint32_t encode(string_view s)
+    {
+        own();
+        uint64_t h = hash64(s);
+        size_t p = find_slot(s, h);
+        if (slots[p] != EMPTY)
+            return slots[p];
+        uint32_t code = size();
+        slots[p] = code;
+        hashes.push_back(h);
+        pool.insert(pool.end(), s.begin(), s.end());
+        offsets.push_back(pool.size());
+        if (size() * 2 > slots.size())
+            grow();
+        return code;
+    }
+
+    // Code of s, or -1 when the value does not occur in the column.
+    long long lookup(string_view s) const
+    {
+        if (extPool)
+        {
+            for (size_t c = 0; c < extSize; c++)
+                if (decode(c) == s)
+                    return c;
+            return -1;
+        }
+        size_t p = find_slot(s, hash64(s));
+        return slots[p] == EMPTY ? -1 : slots[p];
+    }
+
+    string_view decode(uint32_t code) const
+    {
+        if (extPool)
+            return string_view(extPool + extOffsets[code], extOffsets[code + 1] - extOffsets[code]);
+        return string_view(pool.data() + offsets[code], offsets[code + 1] - offsets[code]);
+    }
+
+    size_t size() const { return extPool ? extSize : hashes.size(); }
+};
+
+// One column's row codes: owned, or a read-only array borrowed in place (a
+// snapshot's) that is copied on the first edit.
+class CodeArray
+{
+private:
+    vector<uint32_t> owned;
+    const uint32_t *ext;
+    size_t extSize;
+    shared_ptr<const void> keep;
+
+public:
+    CodeArray() : ext(nullptr), extSize(0) {}
+
+    void borrow(const uint32_t *codes, size_t n, shared_ptr<const void> owner)
+    {
+        owned.clear();
+        ext = codes;
+        extSize = n;
+        keep = move(owner);
+    }
+
+    // The codes as an editable vector; a borrowed array is copied first.
+    vector<uint32_t> &own()
+    {
+        if (ext)
+        {
+            owned.assign(ext, ext + extSize);
+            ext = nullptr;
+            extSize = 0;
+            keep.reset();
+        }
+        return owned;
+    }
+
+    size_t size() const { return ext ? extSize : owned.size(); }
+    const uint32_t *data() const { return ext ? ext : owned.data(); }
+    const uint32_t *begin() const { return data(); }
+    const uint32_t *end() const { return data() + size(); }
+    uint32_t operator[](size_t i) const { return data()[i]; }
+};
+
+struct EncodedColumn
+{
+    ColumnDictionary dict;
+    CodeArray codes;
+};
+
+// Columns an EncodedTable reads in place from elsewhere (a mapped snapshot).
+// load() fills a column the first time the table touches it; numbers() hands
+// out a numeric column's values without turning them into strings.
+class ColumnSource
+{
+public:
+    virtual ~ColumnSource() {}
+    virtual void load(int c, EncodedColumn &col) const = 0;
+    virtual bool numbers(int, const double *&, const uint8_t *&) const { return false; }
+};
+
+// The row table, stored column by column: each column is a dictionary plus one
+// 32-bit code per row, so a value repeated across rows is stored once and
+// comparisons, hashing and per-value work (dictionary lookups, scoring,
+// parsing) run on the codes. Strings are decoded only for display and saving.
+// Rows keep the width they were read with. Cells past a row's width read as ""
+// but are not displayed, saved or compared, so a short row is never equal to
+// the same row padded with empty cells.
+//
+// A table attached to a ColumnSource loads each column on first access
+// (thread-safe, so concurrent readers may share the table) and keeps using the
+// source's memory until the column is edited.
+class EncodedTable
+{
+private:
+    struct LoadOnce
+    {
+        once_flag once;
+        atomic<bool> done{false};
+    };
+    struct Lazy
+    {
+        int src = -1;               // source column while the column is unedited
+        unique_ptr<LoadOnce> state; // set while the column may still need loading
+    };
+
+    mutable vector<EncodedColumn> cols; // filled in by load() on first access
+    vector<uint32_t> widths;
+    vector<Lazy> lazy;
+    shared_ptr<const ColumnSource> source;
+
+    void load(size_t j) const
+    {
+        LoadOnce *st = lazy[j].state.get();
+        if (!st || st->done.load(memory_order_acquire))
+            return;
+        call_once(st->once, [&]() {
+            source->load(lazy[j].src, cols[j]);
+            st->done.store(true, memory_order_release);
+        });
+    }
+
+    const EncodedColumn &col(size_t j) const
+    {
+        load(j);
+        return cols[j];
+    }
+
+    // Column j is about to change: it stops following its source.
+    EncodedColumn &edit(size_t j)
+    {
+        load(j);
+        lazy[j].src = -1;
+        return cols[j];
+    }
+
+    void load_all() const
+    {
+        for (size_t j = 0; j < cols.size(); j++)
+            load(j);
+    }
+
+public:
+    EncodedTable() {}
+
+    // Copies share the source's memory; columns not loaded yet are loaded first.
+    EncodedTable(const EncodedTable &o) : widths(o.widths), source(o.source)
+    {
+        o.load_all();
+        cols = o.cols;
+        lazy.resize(o.lazy.size());
+        for (size_t j = 0; j < lazy.size(); j++)
+            lazy[j].src = o.lazy[j].src;
+    }
+
+    EncodedTable(EncodedTable &&) = default;
+    EncodedTable &operator=(EncodedTable &&) = default;
+
+    EncodedTable &operator=(const EncodedTable &o)
+    {
+        if (this != &o)
+            *this = EncodedTable(o);
+        return *this;
+    }
+
+    // Columns added for a row wider than any before it (or for a header wider
+    // than every row) read as "" in the existing rows.
+    void ensure_columns(size_t n)
+    {
+        while (cols.size() < n)
+        {
+            cols.emplace_back();
+            lazy.emplace_back();
+            EncodedColumn &c = cols.back();
+            c.codes.own().assign(widths.size(), c.dict.encode(""));
+        }
+    }
+
+    size_t rows() const { return widths.size(); }
+    size_t size() const { return widths.size(); }
+    bool empty() const { return widths.empty(); }
+    size_t columns() const { return cols.size(); }
+    size_t width(size_t i) const { return widths[i]; }
+    const EncodedColumn &column(int j) const { return col(j); }
+
+    // A numeric source column's values and null bitmap, while the column is unedited.
+    bool source_numbers(int j, const double *&vals, const uint8_t *&nulls) const
+    {
+        return lazy[j].src >= 0 && source->numbers(lazy[j].src, vals, nulls);
+    }
+
+    string_view cell(size_t i, int j) const
+    {
+        if (j < 0 || (size_t)j >= cols.size())
+            return string_view();
+        const EncodedColumn &c = col(j);
+        return c.dict.decode(c.codes[i]);
+    }
+
+    vector<string> row(size_t i) const
+    {
+        vector<string> r;
+        r.reserve(widths[i]);
+        for (size_t j = 0; j < widths[i]; j++)
+            r.emplace_back(cell(i, j));
+        return r;
+    }
+
+    // Writes one cell. Distinct columns may be written from different threads.
+    void set(size_t i, int j, string_view v)
+    {
+        EncodedColumn &c = edit(j);
+        c.codes.own()[i] = c.dict.encode(v);
+    }
+
+    // Appends parsed rows; columns are independent, so they are encoded in parallel.
+    void append_rows(const vector<vector<string>> &batch)
+    {
+        size_t base = widths.size(), w = 0;
+        for (const vector<string> &r : batch)
+        {
+            widths.push_back(r.size());
+            w = max(w, r.size());
+        }
+        ensure_columns(w);
+        parallel_for(0, cols.size(), 1, [&](size_t j, size_t) {
+            EncodedColumn &c = edit(j);
+            vector<uint32_t> &codes = c.codes.own();
+            codes.resize(widths.size());
+            for (size_t k = 0; k < batch.size(); k++)
+                codes[base + k] = c.dict.encode(j < batch[k].size() ? string_view(batch[k][j]) : string_view());
+        });
+    }
+
+    // Reads `ncols` columns of `nrows` rows from `src`, each on first use; every row spans all of them.
+    void attach(size_t nrows, size_t ncols, shared_ptr<const ColumnSource> src)
+    {
+        clear();
+        source = move(src);
+        cols.resize(ncols);
+        lazy.resize(ncols);
+        for (size_t j = 0; j < ncols; j++)
+        {
+            lazy[j].src = j;
+            lazy[j].state.reset(new LoadOnce());
+        }
+        widths.assign(nrows, ncols);
+    }
+
+    void clear()
+    {
+        cols.clear();
+        widths.clear();
+        lazy.clear();
+        source.reset();
+    }
+
+    void erase_column(size_t j)
+    {
+        if (j >= cols.size())
+            return;
+        cols.erase(cols.begin() + j);
+        lazy.erase(lazy.begin() + j);
+        for (uint32_t &w : widths)
+            if (w > j)
+                w--;
+    }
+
+    // Keeps the rows whose `drop` flag is false, in order.
+    void compact(const vector<bool> &drop)
+    {
+        parallel_for(0, cols.size() + 1, 1, [&](size_t j, size_t) {
+            vector<uint32_t> &v = j < cols.size() ? edit(j).codes.own() : widths;
+            size_t w = 0;
+            for (size_t i = 0; i < v.size(); i++)
+                if (!drop[i])
+                    v[w++] = v[i];
+            v.resize(w);
+        });
+    }
+
+    // Row k of the result is row order[k] of this table.
+    void reorder(const vector<int> &order)
+    {
+        parallel_for(0, cols.size() + 1, 1, [&](size_t j, size_t) {
+            vector<uint32_t> out(order.size());
+            if (j < cols.size())
+            {
+                EncodedColumn &c = edit(j);
+                for (size_t k = 0; k < order.size(); k++)
+                    out[k] = c.codes[order[k]];
+                c.codes.own().swap(out);
+                return;
+            }
+            for (size_t k = 0; k < order.size(); k++)
+                out[k] = widths[order[k]];
+            widths.swap(out);
+        });
+    }
+
+    uint64_t row_hash(size_t i) const
+    {
+        uint64_t h = 1469598103934665603ULL ^ widths[i];
+        for (size_t j = 0; j < widths[i]; j++)
+            h = (h ^ col(j).codes[i]) * 1099511628211ULL;
+        return h ^ (h >> 29);
+    }
+
+    bool rows_equal(size_t a, size_t b) const
+    {
+        if (widths[a] != widths[b])
+            return false;
+        for (size_t j = 0; j < widths[a]; j++)
+            if (col(j).codes[a] != col(j).codes[b])
+                return false;
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,456 @@
+#ifndef GROUPBY_H
+#define GROUPBY_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <unordered_set>
+#include <algorithm>
+#include "NumParse.h"
+#include "ThreadPool.h"
+#include "DictColumn.h"
+
+using namespace std;
+
+enum AggOp
+{
+    AGG_COUNT,
+    AGG_SUM,
+    AGG_MEAN,
+    AGG_MIN,
+    AGG_MAX,
+    AGG_DISTINCT
+};
+
+struct AggSpec
+{
+    AggOp op;
+    int col; // ignored for AGG_COUNT
+};
+
+struct AggState
+{
+    long long rows = 0; // rows in the group
+    long long nums = 0; // numeric, non-empty cells seen
+    double sum = 0;
+    double minVal = 1e300;
+    double maxVal = -1e300;
+};
+
+struct GroupEntry
+{
+    uint64_t hash;
+    vector<string> key;
+    vector<uint32_t> codes; // dictionary codes of the key parts, when grouping on codes
+    vector<AggState> aggs;
+    vector<unordered_set<uint32_t>> distinct; // codes seen, one set per AGG_DISTINCT aggregate
+};
+
+// Open-addressing table from a group key to a GroupEntry. Slots hold only an
+// index into `entries`, so probing touches a small contiguous array.
+class FlatGroupTable
+{
+private:
+    vector<int32_t> slots;
+    size_t mask;
+
+    void grow()
+    {
+        vector<int32_t> old;
+        old.swap(slots);
+        slots.assign(old.size() * 2, -1);
+        mask = slots.size() - 1;
+        for (int32_t idx : old)
+            if (idx >= 0)
+            {
+                size_t p = entries[idx].hash & mask;
+                while (slots[p] >= 0)
+                    p = (p + 1) & mask;
+                slots[p] = idx;
+            }
+    }
+
+public:
+    vector<GroupEntry> entries;
+
+    FlatGroupTable(size_t initial = 1024)
+    {
+        size_t cap = 16;
+        while (cap < initial * 2)
+            cap <<= 1;
+        slots.assign(cap, -1);
+        mask = cap - 1;
+    }
+
+    // Returns the entry whose key satisfies `same(entry)`, creating it with `fill(entry)` if needed.
+    template <typename Same, typename Fill>
+    GroupEntry &find_or_insert_if(uint64_t h, Same same, Fill fill, size_t naggs, size_t ndistinct)
+    {
+        size_t p = h & mask;
+        while (slots[p] >= 0)
+        {
+            GroupEntry &e = entries[slots[p]];
+            if (e.hash == h && same(e))
+                return e;
+            p = (p + 1) & mask;
+        }
+        slots[p] = (int32_t)entries.size();
+        GroupEntry e;
+        e.hash = h;
+        fill(e);
+        e.aggs.resize(naggs);
+        e.distinct.resize(ndistinct);
+        entries.push_back(move(e));
+        if (entries.size() * 10 > slots.size() * 7)
+            grow();
+        return entries.back();
+    }
+
+    // Returns the entry for the key, creating it if needed. `keyAt(i)` yields the i-th key part.
+    template <typename KeyAt>
+    GroupEntry &find_or_insert(uint64_t h, size_t keyLen, KeyAt keyAt, size_t naggs, size_t ndistinct)
+    {
+        return find_or_insert_if(
+            h,
+            [&](const GroupEntry &e) {
+                for (size_t k = 0; k < keyLen; k++)
+                    if (e.key[k] != keyAt(k))
+                        return false;
+                return true;
+            },
+            [&](GroupEntry &e) {
+                for (size_t k = 0; k < keyLen; k++)
+                    e.key.push_back(keyAt(k));
+            },
+            naggs, ndistinct);
+    }
+};
+
+// Hash group-by over the encoded row table. Keys are hashed and compared as one
+// dictionary code per key column, and aggregates read the value column's code:
+// numbers are parsed once per distinct value and distinct counts are sets of
+// codes. Each pool task pre-aggregates its slice of rows
+// into a thread-local FlatGroupTable and the tables are merged at the end. If
+// any local table grows past maxGroups, the operator falls back to spilling
+// key and aggregate columns into hash partitions on disk and aggregating one
+// partition at a time, so only one partition's groups are resident at once.
+class GroupBy
+{
+private:
+    vector<int> keys;
+    vector<AggSpec> aggs;
+    vector<int> aggCols;
+    vector<int> distinctSlot;
+    size_t ndistinct;
+    size_t maxGroups;
+    int threads;
+    vector<vector<ParsedNum>> parsed; // per aggregate: the value column's dictionary, parsed
+    vector<int64_t> emptyCode;        // per aggregate: code of "" in the value column, or -1
+
+    static uint64_t hash_str(string_view s, uint64_t h)
+    {
+        for (unsigned char c : s)
+            h = (h ^ c) * 1099511628211ULL;
+        return h;
+    }
+
+    // Parses each value column's dictionary once, for the numeric aggregates,
+    // and finds the code of the empty cell for the distinct ones.
+    void prepare(const EncodedTable &rows)
+    {
+        parsed.assign(aggs.size(), vector<ParsedNum>());
+        emptyCode.assign(aggs.size(), -1);
+        for (size_t a = 0; a < aggs.size(); a++)
+        {
+            if (aggs[a].op == AGG_COUNT)
+                continue;
+            const ColumnDictionary &dict = rows.column(aggCols[a]).dict;
+            if (aggs[a].op == AGG_DISTINCT)
+            {
+                for (uint32_t c = 0; c < dict.size() && emptyCode[a] < 0; c++)
+                    if (dict.decode(c).empty())
+                        emptyCode[a] = c;
+                continue;
+            }
+            parsed[a].resize(dict.size());
+            for (uint32_t c = 0; c < dict.size(); c++)
+                parsed[a][c] = parse_number(dict.decode(c));
+        }
+    }
+
+    template <typename CodeAt>
+    void accumulate_row(GroupEntry &e, CodeAt codeAt)
+    {
+        for (size_t a = 0; a < aggs.size(); a++)
+        {
+            AggState &st = e.aggs[a];
+            st.rows++;
+            if (aggs[a].op == AGG_COUNT)
+                continue;
+            uint32_t code = codeAt(a);
+            if (aggs[a].op == AGG_DISTINCT)
+            {
+                if (code != emptyCode[a])
+                    e.distinct[distinctSlot[a]].insert(code);
+                continue;
+            }
+            const ParsedNum &num = parsed[a][code];
+            if (num.ok())
+            {
+                double v = num.value;
+                st.nums++;
+                st.sum += v;
+                st.minVal = min(st.minVal, v);
+                st.maxVal = max(st.maxVal, v);
+            }
+        }
+    }
+
+    // Hash of the key strings; used to pick a row's spill partition.
+    uint64_t key_hash(const EncodedTable &rows, size_t i) const
+    {
+        uint64_t h = 1469598103934665603ULL;
+        for (int k : keys)
+            h = hash_str(rows.cell(i, k), h) * 31 + 0x9e37;
+        return h;
+    }
+
+    static uint64_t key_hash(const vector<string> &key)
+    {
+        uint64_t h = 1469598103934665603ULL;
+        for (const string &k : key)
+            h = hash_str(k, h) * 31 + 0x9e37;
+        return h;
+    }
+
+    // A spilled record: the key strings and one value code per aggregate.
+    void add_row(FlatGroupTable &t, const vector<string> &key, const vector<uint32_t> &codes)
+    {
+        GroupEntry &e = t.find_or_insert(
+            key_hash(key), key.size(), [&](size_t k) -> const string & { return key[k]; }, aggs.size(), ndistinct);
+        accumulate_row(e, [&](size_t a) { return codes[a]; });
+    }
+
+    // Same as add_row for row i of the table, but the key is hashed and compared as one
+    // integer code per key column. Codes are global per column, so tables built this
+    // way merge on hash + key.
+    void add_row_codes(FlatGroupTable &t, const EncodedTable &rows, size_t i)
+    {
+        uint64_t h = 1469598103934665603ULL;
+        for (int k : keys)
+            h = (h ^ rows.column(k).codes[i]) * 1099511628211ULL;
+        h ^= h >> 29;
+        GroupEntry &e = t.find_or_insert_if(
+            h,
+            [&](const GroupEntry &g) {
+                for (size_t k = 0; k < keys.size(); k++)
+                    if (g.codes[k] != rows.column(keys[k]).codes[i])
+                        return false;
+                return true;
+            },
+            [&](GroupEntry &g) {
+                for (int k : keys)
+                {
+                    g.codes.push_back(rows.column(k).codes[i]);
+                    g.key.emplace_back(rows.cell(i, k));
+                }
+            },
+            aggs.size(), ndistinct);
+        accumulate_row(e, [&](size_t a) { return rows.column(aggCols[a]).codes[i]; });
+    }
+
+    void merge_into(FlatGroupTable &dst, GroupEntry &src)
+    {
+        GroupEntry &e = dst.find_or_insert(
+            src.hash, keys.size(), [&](size_t k) -> const string & { return src.key[k]; }, aggs.size(), ndistinct);
+        for (size_t a = 0; a < aggs.size(); a++)
+        {
+            AggState &d = e.aggs[a];
+            const AggState &s = src.aggs[a];
+            d.rows += s.rows;
+            d.nums += s.nums;
+            d.sum += s.sum;
+            d.minVal = min(d.minVal, s.minVal);
+            d.maxVal = max(d.maxVal, s.maxVal);
+        }
+        for (size_t d = 0; d < ndistinct; d++)
+        {
+            if (e.distinct[d].empty())
+                e.distinct[d].swap(src.distinct[d]);
+            else
+                e.distinct[d].insert(src.distinct[d].begin(), src.distinct[d].end());
+        }
+    }
+
+    void emit_all(FlatGroupTable &t, const function<void(const vector<string> &, const vector<double> &)> &emit)
+    {
+        vector<double> out(aggs.size());
+        for (GroupEntry &e : t.entries)
+        {
+            for (size_t a = 0; a < aggs.size(); a++)
+            {
+                const AggState &st = e.aggs[a];
+                switch (aggs[a].op)
+                {
+                case AGG_COUNT:
+                    out[a] = st.rows;
+                    break;
+                case AGG_SUM:
+                    out[a] = st.sum;
+                    break;
+                case AGG_MEAN:
+                    out[a] = st.nums ? st.sum / st.nums : 0;
+                    break;
+                case AGG_MIN:
+                    out[a] = st.nums ? st.minVal : 0;
+                    break;
+                case AGG_MAX:
+                    out[a] = st.nums ? st.maxVal : 0;
+                    break;
+                case AGG_DISTINCT:
+                    out[a] = e.distinct[distinctSlot[a]].size();
+                    break;
+                }
+            }
+            emit(e.key, out);
+        }
+    }
+
+    static void put_field(FILE *f, string_view s)
+    {
+        uint32_t len = s.size();
+        fwrite(&len, sizeof(len), 1, f);
+        fwrite(s.data(), 1, len, f);
+    }
+
+    static bool get_field(FILE *f, string &s)
+    {
+        uint32_t len;
+        if (fread(&len, sizeof(len), 1, f) != 1)
+            return false;
+        s.resize(len);
+        return fread(&s[0], 1, len, f) == len;
+    }
+
+    static void close_all(vector<FILE *> &files)
+    {
+        for (FILE *f : files)
+            if (f)
+                fclose(f);
+    }
+
+    // Partitions rows by key hash on disk; each partition holds disjoint groups.
+    // Returns false, before emitting anything, if the partitions cannot be
+    // created or written (e.g. the temp directory is full or unwritable).
+    bool run_spilled(const EncodedTable &rows,
+                     const function<void(const vector<string> &, const vector<double> &)> &emit)
+    {
+        size_t parts = 16;
+        vector<FILE *> files(parts, nullptr);
+        for (auto &f : files)
+            if (!(f = tmpfile()))
+            {
+                close_all(files);
+                return false;
+            }
+        // Inside a partition file the record layout is [key strings..., agg value codes...];
+        // codes stay valid because the table is not edited while the group-by runs.
+        vector<uint32_t> codes(aggs.size(), 0);
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            FILE *f = files[(key_hash(rows, i) >> 32) % parts];
+            for (int k : keys)
+                put_field(f, rows.cell(i, k));
+            for (size_t a = 0; a < aggs.size(); a++)
+                codes[a] = aggCols[a] < 0 ? 0 : rows.column(aggCols[a]).codes[i];
+            fwrite(codes.data(), sizeof(uint32_t), codes.size(), f);
+        }
+        for (FILE *f : files)
+            if (fflush(f) != 0 || ferror(f))
+            {
+                close_all(files);
+                return false;
+            }
+        for (FILE *f : files)
+        {
+            rewind(f);
+            FlatGroupTable t;
+            vector<string> key(keys.size());
+            bool ok = true;
+            while (ok)
+            {
+                for (size_t k = 0; k < keys.size() && ok; k++)
+                    ok = get_field(f, key[k]);
+                ok = ok && fread(codes.data(), sizeof(uint32_t), codes.size(), f) == codes.size();
+                if (ok)
+                    add_row(t, key, codes);
+            }
+            emit_all(t, emit);
+            fclose(f);
+        }
+        return true;
+    }
+
+public:
+    bool spilled;
+    bool spillFailed; // spilling was needed but failed, so the groups were built in memory
+
+    GroupBy(const vector<int> &keyCols, const vector<AggSpec> &aggSpecs, size_t maxGroupsInMemory = 1000000,
+            int workers = 0)
+        : keys(keyCols), aggs(aggSpecs), ndistinct(0), maxGroups(maxGroupsInMemory), spilled(false), spillFailed(false)
+    {
+        threads = workers > 0 ? workers : ThreadPool::global().size();
+        for (const AggSpec &a : aggs)
+        {
+            distinctSlot.push_back(a.op == AGG_DISTINCT ? (int)ndistinct++ : -1);
+            aggCols.push_back(a.op == AGG_COUNT ? -1 : a.col);
+        }
+    }
+
+    // Calls emit(keyParts, aggregateValues) once per group, in no particular order.
+    void run(const EncodedTable &rows, const function<void(const vector<string> &, const vector<double> &)> &emit)
+    {
+        size_t n = rows.size();
+        prepare(rows);
+        int nt = (int)max((size_t)1, min((size_t)threads, n / 4096));
+        vector<FlatGroupTable> local(nt);
+        atomic<bool> tooMany(false);
+        parallel_for(0, nt, 1, [&](size_t t, size_t) {
+            size_t from = n * t / nt, to = n * (t + 1) / nt;
+            for (size_t i = from; i < to; i++)
+            {
+                add_row_codes(local[t], rows, i);
+                if ((i & 1023) == 0 && local[t].entries.size() > maxGroups)
+                {
+                    tooMany = true;
+                    return;
+                }
+                if (tooMany)
+                    return;
+            }
+        });
+
+        if (tooMany)
+        {
+            local.clear();
+            spilled = true;
+            if (run_spilled(rows, emit))
+                return;
+            spilled = false;
+            spillFailed = true;
+            local.assign(1, FlatGroupTable());
+            for (size_t i = 0; i < n; i++)
+                add_row_codes(local[0], rows, i);
+            nt = 1;
+        }
+        for (int t = 1; t < nt; t++)
+            for (GroupEntry &e : local[t].entries)
+                merge_into(local[0], e);
+        emit_all(local[0], emit);
+    }
+};
+
+#endif
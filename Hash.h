@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include "Arena.h"
 
 using namespace std;
 
@@ -19,6 +20,7 @@ class Hash
 private:
     int sz;
     vector<HashNode *> b;
+    Arena pool;
 
     int get_h(string s)
     {
@@ -29,15 +31,18 @@ private:
     }
 
 public:
-    Hash(int s) : sz(s)
+    Hash(int s) : sz(s > 0 ? s : 1), pool(1 << 16)
     {
         b.resize(sz, nullptr);
     }
 
+    Hash(const Hash &) = delete;
+    Hash &operator=(const Hash &) = delete;
+
     void add(string k, int v)
     {
         int h = get_h(k);
-        HashNode *n = new HashNode(k, v);
+        HashNode *n = pool.create<HashNode>(k, v);
         n->nxt = b[h];
         b[h] = n;
     }
@@ -54,6 +59,8 @@ public:
         }
         return -1;
     }
+
+    ArenaStats memory_stats() { return pool.stats(); }
 };
 
 #endif
\ No newline at end of file
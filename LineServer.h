@@ -0,0 +1,166 @@
+#ifndef LINESERVER_H
+#define LINESERVER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Line-oriented server on a Unix domain socket. Every connection gets its own
+// thread; each received line is passed to the handler and the returned text is
+// sent back. At most `maxClients` connections are served at once; further ones
+// wait in the listen backlog until a client leaves. A handler sets `close` to
+// end its connection, and stop() (callable from any handler) shuts the whole
+// server down.
+class LineServer
+{
+public:
+    typedef function<string(const string &line, bool &close)> Handler;
+
+private:
+    string path;
+    int listenFd;
+    size_t maxClients;
+    atomic<bool> running;
+    mutex clientMutex;
+    condition_variable clientsChanged; // a client left, or stop() was called
+    vector<int> clients; // open connections; each is served by a detached thread
+
+    static bool send_all(int fd, const string &s)
+    {
+        size_t off = 0;
+        while (off < s.size())
+        {
+            ssize_t n = send(fd, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            off += n;
+        }
+        return true;
+    }
+
+    void serve_client(int fd, Handler handler)
+    {
+        string pending;
+        char buf[4096];
+        bool close = false;
+        while (!close)
+        {
+            size_t nl;
+            while (!close && (nl = pending.find('\n')) != string::npos)
+            {
+                string line = pending.substr(0, nl);
+                pending.erase(0, nl + 1);
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                if (!send_all(fd, handler(line, close)))
+                    close = true;
+            }
+            if (close)
+                break;
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0)
+                break;
+            pending.append(buf, n);
+        }
+        lock_guard<mutex> lk(clientMutex);
+        clients.erase(find(clients.begin(), clients.end(), fd));
+        ::close(fd);
+        clientsChanged.notify_all();
+    }
+
+public:
+    LineServer(const string &socketPath, size_t maxClients = 64)
+        : path(socketPath), listenFd(-1), maxClients(max<size_t>(maxClients, 1)), running(false)
+    {
+    }
+
+    LineServer(const LineServer &) = delete;
+    LineServer &operator=(const LineServer &) = delete;
+
+    ~LineServer()
+    {
+        stop();
+        if (listenFd >= 0)
+            ::close(listenFd);
+    }
+
+    bool listen_on()
+    {
+        sockaddr_un addr = {};
+        if (path.size() >= sizeof(addr.sun_path))
+            return false;
+        addr.sun_family = AF_UNIX;
+        path.copy(addr.sun_path, path.size());
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0)
+            return false;
+        unlink(path.c_str());
+        if (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, 64) < 0)
+        {
+            ::close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+        running = true;
+        return true;
+    }
+
+    // Accepts connections until stop(); returns after every client thread has finished.
+    void run(Handler handler)
+    {
+        while (running)
+        {
+            {
+                unique_lock<mutex> lk(clientMutex);
+                clientsChanged.wait(lk, [&]() { return clients.size() < maxClients || !running; });
+            }
+            if (!running)
+                break;
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0)
+            {
+                if (!running)
+                    break;
+                continue;
+            }
+            lock_guard<mutex> lk(clientMutex);
+            clients.push_back(fd);
+            thread(&LineServer::serve_client, this, fd, handler).detach();
+        }
+        unique_lock<mutex> lk(clientMutex);
+        // Under the lock, so stop() never shuts down a reused descriptor number.
+        ::close(listenFd);
+        listenFd = -1;
+        unlink(path.c_str());
+        // Only the read side, so a reply already being sent still goes out.
+        for (int fd : clients)
+            shutdown(fd, SHUT_RD);
+        clientsChanged.wait(lk, [&]() { return clients.empty(); });
+    }
+
+    // Makes run() return; safe to call from a handler.
+    void stop()
+    {
+        if (running.exchange(false))
+        {
+            // Taking the lock orders this with run()'s check of `running` and
+            // with its close of the listening socket.
+            lock_guard<mutex> lk(clientMutex);
+            if (listenFd >= 0)
+                shutdown(listenFd, SHUT_RDWR);
+            clientsChanged.notify_all();
+        }
+    }
+};
+
+#endif
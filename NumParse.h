@@ -0,0 +1,114 @@
+#ifndef NUMPARSE_H
+#define NUMPARSE_H
+
+#include <charconv>
+#include <string_view>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+enum NumKind
+{
+    NUM_NULL,    // empty or blank cell
+    NUM_INVALID, // anything that is not a plain decimal number
+    NUM_INTEGER,
+    NUM_REAL
+};
+
+struct ParsedNum
+{
+    NumKind kind;
+    double value;     // valid for NUM_INTEGER and NUM_REAL
+    long long ivalue; // valid for NUM_INTEGER that fits in 64 bits
+
+    bool ok() const { return kind == NUM_INTEGER || kind == NUM_REAL; }
+};
+
+// Returns the end of the run of ASCII digits starting at p. With SSE2 it tests
+// 16 bytes per step: (c - '0') as unsigned is <= 9 exactly for digits.
+inline const char *digit_run(const char *p, const char *end)
+{
+#if defined(__SSE2__)
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i flip = _mm_set1_epi8((char)0x80);
+    const __m128i nine = _mm_set1_epi8((char)(0x80 ^ 9));
+    while (end - p >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i s = _mm_xor_si128(_mm_sub_epi8(v, zero), flip);
+        int bad = _mm_movemask_epi8(_mm_cmpgt_epi8(s, nine));
+        if (bad)
+            return p + __builtin_ctz(bad);
+        p += 16;
+    }
+#endif
+    while (p < end && (unsigned char)(*p - '0') <= 9)
+        p++;
+    return p;
+}
+
+// Single pass validate-and-convert for one cell. Accepts [+-]digits[.digits][(e|E)[+-]digits]
+// with at least one mantissa digit, e.g. "42", "+3", "-0.5", ".5", "1e5".
+// Rejects "-", ".", "inf", "nan", hex and surrounding spaces.
+inline ParsedNum parse_number(string_view s)
+{
+    ParsedNum r{NUM_INVALID, 0.0, 0};
+    const char *p = s.data(), *end = p + s.size();
+    if (s.empty() || s == " ")
+    {
+        r.kind = NUM_NULL;
+        return r;
+    }
+
+    const char *start = p;
+    if (*p == '+' || *p == '-')
+        p++;
+    const char *intBegin = p;
+    p = digit_run(p, end);
+    size_t digits = p - intBegin;
+    bool real = false;
+    if (p < end && *p == '.')
+    {
+        const char *frac = ++p;
+        p = digit_run(p, end);
+        digits += p - frac;
+        real = true;
+    }
+    if (digits == 0)
+        return r;
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+        if (p < end && (*p == '+' || *p == '-'))
+            p++;
+        const char *exp = p;
+        p = digit_run(p, end);
+        if (p == exp)
+            return r;
+        real = true;
+    }
+    if (p != end)
+        return r;
+
+    // from_chars does not take a leading '+'.
+    const char *num = (*start == '+') ? start + 1 : start;
+    if (!real)
+    {
+        auto res = from_chars(num, end, r.ivalue);
+        if (res.ec == errc() && res.ptr == end)
+        {
+            r.kind = NUM_INTEGER;
+            r.value = (double)r.ivalue;
+            return r;
+        }
+    }
+    auto res = from_chars(num, end, r.value);
+    if (res.ec != errc() || res.ptr != end)
+        return r;
+    r.kind = real ? NUM_REAL : NUM_INTEGER;
+    return r;
+}
+
+#endif
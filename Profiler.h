@@ -0,0 +1,204 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Lightweight instrumentation: scoped timers, named counters, allocation counts
+// and an optional Chrome trace dump (load the JSON in chrome://tracing or Perfetto).
+//
+// Build with -DDSA_PROFILE to enable; without it every macro expands to nothing.
+//   PROF_SCOPE("name")         time the enclosing block
+//   PROF_COUNT("name", n)      add n to a counter (rows, bytes processed, ...)
+//   PROF_FINISH()              print the summary; writes $DSA_TRACE as trace JSON if set
+//
+// Allocation counts are process-wide, so scopes running concurrently see each
+// other's allocations. When enabled this header replaces global operator new/delete
+// to count allocations, so it may only be included by one translation unit per program.
+
+#ifdef DSA_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+inline atomic<long long> &prof_alloc_count()
+{
+    static atomic<long long> n(0);
+    return n;
+}
+
+inline atomic<long long> &prof_alloc_bytes()
+{
+    static atomic<long long> n(0);
+    return n;
+}
+
+// GCC cannot see that these replacements pair malloc with free. The warning
+// is silenced for these definitions only.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(size_t sz)
+{
+    prof_alloc_count().fetch_add(1, memory_order_relaxed);
+    prof_alloc_bytes().fetch_add(sz, memory_order_relaxed);
+    if (void *p = malloc(sz ? sz : 1))
+        return p;
+    throw bad_alloc();
+}
+void *operator new[](size_t sz) { return operator new(sz); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+class Profiler
+{
+private:
+    struct ScopeStats
+    {
+        long long calls = 0;
+        double totalMs = 0;
+        double maxMs = 0;
+        long long allocs = 0;
+        long long allocBytes = 0;
+    };
+
+    struct TraceEvent
+    {
+        const char *name;
+        size_t tid;
+        double startUs;
+        double durUs;
+    };
+
+    mutex m;
+    map<string, ScopeStats> scopes;
+    map<string, long long> counters;
+    vector<TraceEvent> events;
+    chrono::steady_clock::time_point epoch;
+
+    Profiler() : epoch(chrono::steady_clock::now()) {}
+
+public:
+    static Profiler &instance()
+    {
+        static Profiler p;
+        return p;
+    }
+
+    double now_us() { return chrono::duration<double, micro>(chrono::steady_clock::now() - epoch).count(); }
+
+    void record(const char *name, double startUs, double durUs, long long allocs, long long allocBytes)
+    {
+        lock_guard<mutex> lock(m);
+        ScopeStats &s = scopes[name];
+        s.calls++;
+        s.totalMs += durUs / 1000.0;
+        s.maxMs = max(s.maxMs, durUs / 1000.0);
+        s.allocs += allocs;
+        s.allocBytes += allocBytes;
+        if (events.size() < 1000000)
+            events.push_back({name, hash<thread::id>()(this_thread::get_id()) % 100000, startUs, durUs});
+    }
+
+    void count(const char *name, long long n)
+    {
+        lock_guard<mutex> lock(m);
+        counters[name] += n;
+    }
+
+    void report()
+    {
+        lock_guard<mutex> lock(m);
+        cout << "\n--- Profile Summary ---" << endl;
+        cout << left << setw(24) << "scope" << right << setw(8) << "calls" << setw(14) << "total ms" << setw(12)
+             << "max ms" << setw(12) << "allocs" << setw(16) << "alloc bytes" << endl;
+        for (auto &kv : scopes)
+            cout << left << setw(24) << kv.first.substr(0, 23) << right << setw(8) << kv.second.calls << setw(14)
+                 << fixed << setprecision(3) << kv.second.totalMs << setw(12) << kv.second.maxMs << setw(12)
+                 << kv.second.allocs << setw(16) << kv.second.allocBytes << endl;
+        cout.unsetf(ios::fixed);
+        for (auto &kv : counters)
+            cout << left << setw(24) << kv.first.substr(0, 23) << right << setw(20) << kv.second << endl;
+        cout << "total allocations: " << prof_alloc_count().load() << " (" << prof_alloc_bytes().load() << " bytes)"
+             << endl;
+    }
+
+    bool dump_trace(const char *filename)
+    {
+        lock_guard<mutex> lock(m);
+        FILE *f = fopen(filename, "w");
+        if (!f)
+            return false;
+        fprintf(f, "{\"traceEvents\":[");
+        for (size_t i = 0; i < events.size(); i++)
+            fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+                    i ? "," : "", events[i].name, events[i].tid, events[i].startUs, events[i].durUs);
+        fprintf(f, "\n]}\n");
+        fclose(f);
+        return true;
+    }
+
+    void finish()
+    {
+        report();
+        if (const char *trace = getenv("DSA_TRACE"))
+            if (dump_trace(trace))
+                cout << "Trace written to " << trace << endl;
+    }
+};
+
+// Scope names must be string literals; only the pointer is kept in the trace buffer.
+class ProfScope
+{
+private:
+    const char *name;
+    double start;
+    long long allocs0, bytes0;
+
+public:
+    ProfScope(const char *n) : name(n)
+    {
+        allocs0 = prof_alloc_count().load(memory_order_relaxed);
+        bytes0 = prof_alloc_bytes().load(memory_order_relaxed);
+        start = Profiler::instance().now_us();
+    }
+    ~ProfScope()
+    {
+        Profiler &p = Profiler::instance();
+        double end = p.now_us();
+        p.record(name, start, end - start, prof_alloc_count().load(memory_order_relaxed) - allocs0,
+                 prof_alloc_bytes().load(memory_order_relaxed) - bytes0);
+    }
+};
+
+#define PROF_CAT2(a, b) a##b
+#define PROF_CAT(a, b) PROF_CAT2(a, b)
+#define PROF_SCOPE(name) ProfScope PROF_CAT(prof_scope_, __LINE__)(name)
+#define PROF_COUNT(name, n) Profiler::instance().count(name, (long long)(n))
+#define PROF_FINISH() Profiler::instance().finish()
+
+#else
+
+#define PROF_SCOPE(name) ((void)0)
+#define PROF_COUNT(name, n) ((void)0)
+#define PROF_FINISH() ((void)0)
+
+#endif
+
+#endif
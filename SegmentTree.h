@@ -52,6 +52,16 @@ private:
         tree[node] = merge(tree[2 * node], tree[2 * node + 1]);
     }
 
+    Node query(int node, int start, int end, int l, int r)
+    {
+        if (r < start || end < l)
+            return Node();
+        if (l <= start && end <= r)
+            return tree[node];
+        int mid = (start + end) / 2;
+        return merge(query(2 * node, start, mid, l, r), query(2 * node + 1, mid + 1, end, l, r));
+    }
+
 public:
     SegmentTree(const vector<double> &data)
     {
@@ -65,6 +75,16 @@ public:
     }
 
     Node getFullStats() { return tree[1]; }
+
+    // Sum/min/max over positions [l, r]; an empty range gives a default Node.
+    Node query(int l, int r)
+    {
+        l = max(l, 0);
+        r = min(r, n - 1);
+        if (n == 0 || l > r)
+            return Node();
+        return query(1, 0, n - 1, l, r);
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+inline uint64_t hash64(string_view s)
+{
+    uint64_t h = 1469598103934665603ULL ^ (s.size() * 0x9e3779b97f4a7c15ULL);
+    for (unsigned char c : s)
+        h = (h ^ c) * 1099511628211ULL;
+    // murmur3 finalizer so the high bits are usable as well as the low ones
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Per-column profile for the analysis view. The table is dictionary-encoded,
+// so rows are counted per code and every figure here is exact.
+struct ColumnSketch
+{
+    struct Entry
+    {
+        string item;
+        long long count;
+    };
+
+    static const size_t TOP = 8;
+
+    long long rows = 0;
+    long long nulls = 0;
+    long long distinct = 0;
+    vector<Entry> top; // most frequent non-null values, largest count first
+
+    static bool is_null(string_view cell) { return cell.empty() || cell == " "; }
+};
+
+#endif
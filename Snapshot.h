@@ -0,0 +1,451 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <charconv>
+#include <memory>
+#include <iostream>
+#include "ThreadPool.h"
+#include "DictColumn.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Binary columnar snapshot (.dsnap).
+//
+// Layout: SnapHeader, then the column blocks, then the column directory.
+// Every block starts on an 8 byte boundary so the reader can use the mapped
+// file directly as double / uint32 / uint64 arrays.
+//   numeric column: double[nrows], null bitmap
+//   string column:  uint32 codes[nrows], null bitmap, uint64 offsets[dictSize + 1], char blob
+// The directory keeps count / min / max / distinct per column, so stats can be
+// read without touching the column data. Null means an empty cell; a column is
+// stored as numeric only when every other cell prints back exactly as written.
+// Null rows of a string column carry the code of an "" entry (nullCode), so the
+// codes and dictionary can serve as a table column as they are.
+
+static const uint32_t SNAP_VERSION = 2;
+
+enum SnapType : uint32_t
+{
+    SNAP_NUMERIC = 0,
+    SNAP_STRING = 1
+};
+
+struct SnapHeader
+{
+    char magic[8];
+    uint64_t nrows;
+    uint32_t ncols;
+    uint32_t version;
+    uint64_t dirOffset;
+};
+
+struct SnapColumn
+{
+    uint32_t type;
+    uint32_t nameLen;
+    uint64_t nameOff;
+    uint64_t dataOff;
+    uint64_t nullOff;
+    uint64_t dictOffsOff;
+    uint64_t dictBlobOff;
+    uint64_t dictSize;
+    uint64_t count; // non-null cells
+    double minVal;  // numeric columns
+    double maxVal;
+    uint32_t minCode; // string columns: codes of the lexicographic min / max
+    uint32_t maxCode;
+    uint32_t nullCode; // string columns: code of null rows, UINT32_MAX when there are none
+    uint32_t reserved;
+};
+
+class SnapshotWriter
+{
+private:
+    FILE *fp;
+    bool failed;
+    uint64_t pos;
+    uint64_t nrows;
+    vector<SnapColumn> dir;
+    vector<string> names;
+
+    void put(const void *p, size_t n)
+    {
+        if (fwrite(p, 1, n, fp) != n)
+            failed = true;
+        pos += n;
+    }
+
+    void align()
+    {
+        static const char zeros[8] = {0};
+        if (pos % 8)
+            put(zeros, 8 - pos % 8);
+    }
+
+    uint64_t put_bitmap(const vector<bool> &nulls)
+    {
+        align();
+        uint64_t off = pos;
+        vector<uint8_t> bits((nrows + 7) / 8, 0);
+        for (uint64_t i = 0; i < nrows; i++)
+            if (nulls[i])
+                bits[i >> 3] |= (uint8_t)(1u << (i & 7));
+        put(bits.data(), bits.size());
+        return off;
+    }
+
+public:
+    SnapshotWriter(string filename, uint64_t rows) : failed(false), pos(0), nrows(rows)
+    {
+        fp = fopen(filename.c_str(), "wb");
+        if (!fp)
+            return;
+        setvbuf(fp, nullptr, _IOFBF, 1 << 20);
+        SnapHeader h{};
+        put(&h, sizeof(h));
+    }
+
+    ~SnapshotWriter() { finish(); }
+
+    bool is_open() { return fp != nullptr; }
+
+    void add_numeric(const string &name, const vector<double> &vals, const vector<bool> &nulls)
+    {
+        SnapColumn c{};
+        c.type = SNAP_NUMERIC;
+        for (uint64_t i = 0; i < nrows; i++)
+            if (!nulls[i])
+            {
+                c.minVal = c.count == 0 ? vals[i] : min(c.minVal, vals[i]);
+                c.maxVal = c.count == 0 ? vals[i] : max(c.maxVal, vals[i]);
+                c.count++;
+            }
+        align();
+        c.dataOff = pos;
+        put(vals.data(), nrows * sizeof(double));
+        c.nullOff = put_bitmap(nulls);
+        dir.push_back(c);
+        names.push_back(name);
+    }
+
+    // Stores a dictionary-encoded column. Only values still used by some row
+    // are written, numbered in order of first use; null rows share one "" entry.
+    void add_string(const string &name, const EncodedColumn &col, const vector<bool> &nulls)
+    {
+        SnapColumn c{};
+        c.type = SNAP_STRING;
+        c.nullCode = UINT32_MAX;
+        vector<uint32_t> remap(col.dict.size(), UINT32_MAX);
+        vector<string_view> dict;
+        vector<uint32_t> codes(nrows, 0);
+        for (uint64_t i = 0; i < nrows; i++)
+        {
+            uint32_t &code = nulls[i] ? c.nullCode : remap[col.codes[i]];
+            if (code == UINT32_MAX)
+            {
+                code = dict.size();
+                dict.push_back(nulls[i] ? string_view() : col.dict.decode(col.codes[i]));
+            }
+            codes[i] = code;
+            c.count += !nulls[i];
+        }
+        bool first = true;
+        for (uint32_t k = 0; k < dict.size(); k++)
+        {
+            if (k == c.nullCode)
+                continue;
+            if (first || dict[k] < dict[c.minCode])
+                c.minCode = k;
+            if (first || dict[k] > dict[c.maxCode])
+                c.maxCode = k;
+            first = false;
+        }
+        c.dictSize = dict.size();
+
+        align();
+        c.dataOff = pos;
+        put(codes.data(), codes.size() * sizeof(uint32_t));
+        c.nullOff = put_bitmap(nulls);
+
+        align();
+        c.dictOffsOff = pos;
+        vector<uint64_t> offs(dict.size() + 1, 0);
+        for (size_t k = 0; k < dict.size(); k++)
+            offs[k + 1] = offs[k] + dict[k].size();
+        put(offs.data(), offs.size() * sizeof(uint64_t));
+        c.dictBlobOff = pos;
+        for (string_view v : dict)
+            put(v.data(), v.size());
+
+        dir.push_back(c);
+        names.push_back(name);
+    }
+
+    // Writes the directory and header; false if any write failed.
+    bool finish()
+    {
+        if (!fp)
+            return !failed;
+        for (size_t i = 0; i < dir.size(); i++)
+        {
+            dir[i].nameOff = pos;
+            dir[i].nameLen = (uint32_t)names[i].size();
+            put(names[i].data(), names[i].size());
+        }
+        align();
+        SnapHeader h{};
+        memcpy(h.magic, "DSNAP01", 8);
+        h.nrows = nrows;
+        h.ncols = (uint32_t)dir.size();
+        h.version = SNAP_VERSION;
+        h.dirOffset = pos;
+        put(dir.data(), dir.size() * sizeof(SnapColumn));
+        if (fseek(fp, 0, SEEK_SET) != 0 || fwrite(&h, 1, sizeof(h), fp) != sizeof(h))
+            failed = true;
+        if (fclose(fp) != 0)
+            failed = true;
+        fp = nullptr;
+        return !failed;
+    }
+};
+
+// Maps a snapshot read-only. Opening checks only the header and directory;
+// to_table() wraps the mapped columns without copying them, and each column's
+// dictionary and codes are validated when the table first touches it.
+class SnapshotReader : public ColumnSource, public enable_shared_from_this<SnapshotReader>
+{
+private:
+    const char *base;
+    size_t len;
+    const SnapHeader *hdr;
+    const SnapColumn *dir;
+#ifdef _WIN32
+    vector<char> owned;
+#endif
+
+    template <typename T>
+    const T *at(uint64_t off) const { return reinterpret_cast<const T *>(base + off); }
+
+    // True when `count` items of `size` bytes at `off` lie inside the mapping.
+    bool fits(uint64_t off, uint64_t count, uint64_t size, uint64_t align = 1) const
+    {
+        return off % align == 0 && off <= len && count <= (len - off) / size;
+    }
+
+    // Checks that every block in the directory lies inside the mapping; the
+    // contents are left to valid_strings(), when a column is first used.
+    bool valid_columns() const
+    {
+        uint64_t n = hdr->nrows;
+        for (uint32_t c = 0; c < hdr->ncols; c++)
+        {
+            const SnapColumn &d = dir[c];
+            if (!fits(d.nameOff, d.nameLen, 1) || !fits(d.nullOff, (n + 7) / 8, 1))
+                return false;
+            if (d.type == SNAP_NUMERIC)
+            {
+                if (!fits(d.dataOff, n, sizeof(double), 8))
+                    return false;
+                continue;
+            }
+            if (d.type != SNAP_STRING || !fits(d.dataOff, n, sizeof(uint32_t), 8) ||
+                d.dictSize >= UINT32_MAX || !fits(d.dictOffsOff, d.dictSize + 1, sizeof(uint64_t), 8) ||
+                d.dictBlobOff > len)
+                return false;
+        }
+        return true;
+    }
+
+    // Dictionary offsets ascend within the blob and every row's code is in range.
+    bool valid_strings(int c) const
+    {
+        const SnapColumn &d = dir[c];
+        const uint64_t *offs = at<uint64_t>(d.dictOffsOff);
+        if (offs[0] != 0)
+            return false;
+        for (uint64_t k = 0; k < d.dictSize; k++)
+            if (offs[k + 1] < offs[k])
+                return false;
+        if (offs[d.dictSize] > len - d.dictBlobOff)
+            return false;
+        const uint32_t *cd = codes(c);
+        uint32_t bad = 0;
+        for (uint64_t r = 0; r < hdr->nrows; r++)
+            bad |= cd[r] >= d.dictSize;
+        return !bad;
+    }
+
+public:
+    SnapshotReader() : base(nullptr), len(0), hdr(nullptr), dir(nullptr) {}
+    ~SnapshotReader() { close(); }
+
+    SnapshotReader(const SnapshotReader &) = delete;
+    SnapshotReader &operator=(const SnapshotReader &) = delete;
+
+    bool open(string filename)
+    {
+        close();
+#ifndef _WIN32
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapHeader))
+        {
+            ::close(fd);
+            return false;
+        }
+        len = st.st_size;
+        void *m = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (m == MAP_FAILED)
+            return false;
+        base = (const char *)m;
+#else
+        FILE *f = fopen(filename.c_str(), "rb");
+        if (!f)
+            return false;
+        fseek(f, 0, SEEK_END);
+        owned.resize(ftell(f));
+        fseek(f, 0, SEEK_SET);
+        len = fread(owned.data(), 1, owned.size(), f);
+        fclose(f);
+        base = owned.data();
+#endif
+        hdr = at<SnapHeader>(0);
+        if (len < sizeof(SnapHeader) || memcmp(hdr->magic, "DSNAP01", 8) != 0 || hdr->version != SNAP_VERSION ||
+            !fits(hdr->dirOffset, hdr->ncols, sizeof(SnapColumn), 8))
+        {
+            close();
+            return false;
+        }
+        dir = at<SnapColumn>(hdr->dirOffset);
+        if (!valid_columns())
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+#ifndef _WIN32
+        if (base)
+            munmap((void *)base, len);
+#else
+        owned.clear();
+#endif
+        base = nullptr;
+        hdr = nullptr;
+        dir = nullptr;
+        len = 0;
+    }
+
+    uint64_t rows() const { return hdr->nrows; }
+    int columns() const { return (int)hdr->ncols; }
+    const SnapColumn &meta(int c) const { return dir[c]; }
+
+    // Distinct non-null values of a string column.
+    uint64_t distinct(int c) const { return dir[c].dictSize - (dir[c].nullCode != UINT32_MAX); }
+    string name(int c) const { return string(base + dir[c].nameOff, dir[c].nameLen); }
+
+    bool is_null(int c, uint64_t row) const
+    {
+        return (at<uint8_t>(dir[c].nullOff)[row >> 3] >> (row & 7)) & 1;
+    }
+
+    // Column data straight from the mapping, no copies.
+    const double *numeric(int c) const { return at<double>(dir[c].dataOff); }
+    const uint32_t *codes(int c) const { return at<uint32_t>(dir[c].dataOff); }
+
+    string_view dict_entry(int c, uint32_t code) const
+    {
+        const uint64_t *offs = at<uint64_t>(dir[c].dictOffsOff);
+        return string_view(base + dir[c].dictBlobOff + offs[code], offs[code + 1] - offs[code]);
+    }
+
+    static string format_number(double v)
+    {
+        char buf[32];
+        auto res = to_chars(buf, buf + sizeof(buf), v);
+        return string(buf, res.ptr);
+    }
+
+    string cell(int c, uint64_t row) const
+    {
+        if (is_null(c, row))
+            return "";
+        if (dir[c].type == SNAP_NUMERIC)
+            return format_number(numeric(c)[row]);
+        return string(dict_entry(c, codes(c)[row]));
+    }
+
+    // Wraps the snapshot as the table; it must be owned by a shared_ptr, which
+    // the table keeps so the mapping outlives it.
+    void to_table(vector<string> &head, EncodedTable &data) const
+    {
+        head.clear();
+        for (int c = 0; c < columns(); c++)
+            head.push_back(name(c));
+        data.attach(rows(), columns(), shared_from_this());
+    }
+
+    // String columns use the mapped dictionary and codes in place. Numbers are
+    // formatted and encoded per cell, which is why that waits until a column is
+    // actually read as text. A corrupt string column reads as empty cells.
+    void load(int c, EncodedColumn &col) const override
+    {
+        col = EncodedColumn();
+        if (dir[c].type == SNAP_STRING && valid_strings(c))
+        {
+            col.dict.borrow(at<uint64_t>(dir[c].dictOffsOff), base + dir[c].dictBlobOff, dir[c].dictSize,
+                            shared_from_this());
+            col.codes.borrow(codes(c), rows(), shared_from_this());
+            return;
+        }
+        vector<uint32_t> &out = col.codes.own();
+        out.resize(rows());
+        uint32_t nullCode = col.dict.encode("");
+        if (dir[c].type == SNAP_STRING)
+        {
+            cout << "Warning: snapshot column " << name(c) << " is corrupt; its cells read as empty." << endl;
+            fill(out.begin(), out.end(), nullCode);
+            return;
+        }
+        char buf[32];
+        const double *vals = numeric(c);
+        for (uint64_t r = 0; r < rows(); r++)
+        {
+            if (is_null(c, r))
+            {
+                out[r] = nullCode;
+                continue;
+            }
+            char *end = to_chars(buf, buf + sizeof(buf), vals[r]).ptr;
+            out[r] = col.dict.encode(string_view(buf, end - buf));
+        }
+    }
+
+    bool numbers(int c, const double *&vals, const uint8_t *&nulls) const override
+    {
+        if (dir[c].type != SNAP_NUMERIC)
+            return false;
+        vals = numeric(c);
+        nulls = at<uint8_t>(dir[c].nullOff);
+        return true;
+    }
+};
+
+#endif
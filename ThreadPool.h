@@ -0,0 +1,304 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <algorithm>
+
+using namespace std;
+
+// Work-stealing thread pool. Every worker owns a deque: it pushes and pops its
+// own tasks at the back and steals from the front of the others' deques when it
+// runs dry. A thread waiting on a TaskGroup runs pending tasks before it
+// blocks, so nested parallel_for calls cannot deadlock the pool.
+class ThreadPool
+{
+private:
+    struct TaskQueue
+    {
+        mutex m;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<TaskQueue>> queues; // one per worker plus one for outside threads
+    vector<thread> workers;
+    mutex sleepMutex;
+    condition_variable wake;
+    atomic<long> pending;
+    atomic<unsigned> nextVictim;
+    bool stop;
+
+    static int &current_index()
+    {
+        static thread_local int idx = -1;
+        return idx;
+    }
+
+    static ThreadPool *&current_pool()
+    {
+        static thread_local ThreadPool *pool = nullptr;
+        return pool;
+    }
+
+    int own_queue() const
+    {
+        return current_pool() == this ? current_index() : (int)workers.size();
+    }
+
+    bool take(int self, function<void()> &task)
+    {
+        int nq = queues.size();
+        if (self >= 0)
+        {
+            TaskQueue &q = *queues[self];
+            lock_guard<mutex> lk(q.m);
+            if (!q.tasks.empty())
+            {
+                task = move(q.tasks.back());
+                q.tasks.pop_back();
+                return true;
+            }
+        }
+        unsigned start = nextVictim++;
+        for (int k = 0; k < nq; k++)
+        {
+            int v = (start + k) % nq;
+            if (v == self)
+                continue;
+            TaskQueue &q = *queues[v];
+            lock_guard<mutex> lk(q.m);
+            if (!q.tasks.empty())
+            {
+                task = move(q.tasks.front());
+                q.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(int idx)
+    {
+        current_pool() = this;
+        current_index() = idx;
+        while (true)
+        {
+            if (try_run_one())
+                continue;
+            unique_lock<mutex> lk(sleepMutex);
+            wake.wait(lk, [&]() { return stop || pending > 0; });
+            if (stop && pending == 0)
+                return;
+        }
+    }
+
+public:
+    // `threads` counts the calling thread, which helps while it waits, so
+    // ThreadPool(1) starts no workers and runs everything inline.
+    explicit ThreadPool(int threads = 0) : pending(0), nextVictim(0), stop(false)
+    {
+        if (threads <= 0)
+            threads = max(1, (int)thread::hardware_concurrency());
+        for (int i = 0; i < threads; i++)
+            queues.emplace_back(new TaskQueue());
+        for (int i = 0; i < threads - 1; i++)
+            workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            lock_guard<mutex> lk(sleepMutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto &w : workers)
+            w.join();
+    }
+
+    // Threads that execute tasks, the waiting caller included.
+    int size() const { return workers.size() + 1; }
+
+    void submit(function<void()> task)
+    {
+        TaskQueue &q = *queues[own_queue()];
+        {
+            lock_guard<mutex> lk(q.m);
+            q.tasks.push_back(move(task));
+        }
+        {
+            lock_guard<mutex> lk(sleepMutex);
+            pending++;
+        }
+        wake.notify_one();
+    }
+
+    // Runs one queued task on the calling thread; false when there was none.
+    bool try_run_one()
+    {
+        function<void()> task;
+        if (!take(own_queue(), task))
+            return false;
+        pending--;
+        task();
+        return true;
+    }
+
+    // The process-wide pool. Its size comes from configure(), else DSA_THREADS,
+    // else the hardware thread count; it is created on first use.
+    static int &configured_threads()
+    {
+        static int n = 0;
+        return n;
+    }
+
+    static void configure(int threads) { configured_threads() = threads; }
+
+    static ThreadPool &global()
+    {
+        static ThreadPool pool([]() {
+            if (configured_threads() > 0)
+                return configured_threads();
+            const char *env = getenv("DSA_THREADS");
+            return env ? atoi(env) : 0;
+        }());
+        return pool;
+    }
+};
+
+// A set of tasks that can be waited on together. wait() runs queued tasks
+// while any are left and then sleeps until the group's last task finishes; the
+// first exception thrown by a task is rethrown from wait().
+class TaskGroup
+{
+private:
+    ThreadPool &pool;
+    mutex m;
+    condition_variable done;
+    int outstanding;
+    exception_ptr error;
+
+    // Waits for every task without rethrowing; tasks reference the group, so
+    // it must not be destroyed while any is queued or running.
+    void drain()
+    {
+        while (true)
+        {
+            {
+                lock_guard<mutex> lk(m);
+                if (outstanding == 0)
+                    return;
+            }
+            if (!pool.try_run_one())
+                break;
+        }
+        unique_lock<mutex> lk(m);
+        done.wait(lk, [&]() { return outstanding == 0; });
+    }
+
+public:
+    explicit TaskGroup(ThreadPool &p = ThreadPool::global()) : pool(p), outstanding(0) {}
+    ~TaskGroup() { drain(); }
+
+    void run(function<void()> fn)
+    {
+        {
+            lock_guard<mutex> lk(m);
+            outstanding++;
+        }
+        pool.submit([this, fn = move(fn)]() {
+            exception_ptr e;
+            try
+            {
+                fn();
+            }
+            catch (...)
+            {
+                e = current_exception();
+            }
+            // Notified under the lock: the waiter may destroy the group as soon
+            // as it sees zero.
+            lock_guard<mutex> lk(m);
+            if (e && !error)
+                error = e;
+            if (--outstanding == 0)
+                done.notify_all();
+        });
+    }
+
+    void wait()
+    {
+        drain();
+        exception_ptr e;
+        {
+            lock_guard<mutex> lk(m);
+            swap(e, error);
+        }
+        if (e)
+            rethrow_exception(e);
+    }
+};
+
+// Calls body(from, to) on consecutive slices of [begin, end) of about `grain`
+// indexes each. Slices depend only on the range and grain, not on the thread
+// count, so reductions built on them give the same answer on any pool size.
+template <typename Body>
+void parallel_for(size_t begin, size_t end, size_t grain, Body body, ThreadPool &pool = ThreadPool::global())
+{
+    if (end <= begin)
+        return;
+    grain = max<size_t>(grain, 1);
+    size_t chunks = (end - begin + grain - 1) / grain;
+    if (chunks == 1 || pool.size() == 1)
+    {
+        for (size_t c = 0; c < chunks; c++)
+            body(begin + c * grain, min(end, begin + (c + 1) * grain));
+        return;
+    }
+    TaskGroup g(pool);
+    for (size_t c = 1; c < chunks; c++)
+    {
+        size_t from = begin + c * grain, to = min(end, from + grain);
+        g.run([&body, from, to]() { body(from, to); });
+    }
+    body(begin, min(end, begin + grain));
+    g.wait();
+}
+
+// Maps each slice to a partial result with map(from, to) and folds the
+// partials in slice order with combine(acc, partial).
+template <typename T, typename Map, typename Combine>
+T parallel_reduce(size_t begin, size_t end, size_t grain, T identity, Map map, Combine combine,
+                  ThreadPool &pool = ThreadPool::global())
+{
+    if (end <= begin)
+        return identity;
+    grain = max<size_t>(grain, 1);
+    size_t chunks = (end - begin + grain - 1) / grain;
+    vector<T> partial(chunks, identity);
+    parallel_for(
+        0, chunks, 1,
+        [&](size_t c0, size_t c1) {
+            for (size_t c = c0; c < c1; c++)
+                partial[c] = map(begin + c * grain, min(end, begin + (c + 1) * grain));
+        },
+        pool);
+    T acc = identity;
+    for (T &p : partial)
+        acc = combine(acc, p);
+    return acc;
+}
+
+#endif
@@ -9,17 +9,40 @@
 #include <queue>
 #include <math.h>
 #include <ctime>
+#include <chrono>
+#include <thread>
+#include <unordered_set>
+#include <unordered_map>
+#include <atomic>
+#include <charconv>
+#include <climits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include "SegmentTree.h"
 #include "Trie.h"
 #include "Hash.h"
 #include "UnionFind.h"
 #include "AVL.h"
+#include "CsvWriter.h"
+#include "Snapshot.h"
+#include "BoundedQueue.h"
+#include "Profiler.h"
+#include "GroupBy.h"
+#include "NumParse.h"
+#include "Sketch.h"
+#include "DictColumn.h"
+#include "ColumnCache.h"
+#include "ThreadPool.h"
+#include "AsyncIO.h"
+#include "LineServer.h"
 
 using namespace std;
 
 struct RowError
 {
-    int id;
+    long long id;
     int score;
     bool operator<(const RowError &other) const
     {
@@ -33,129 +56,199 @@ struct Point
     int cluster;
 };
 
-bool is_num(string s)
+struct PlotBounds
 {
-    if (s.empty())
-        return false;
-    bool dot = false;
-    for (int i = 0; i < s.length(); i++)
-    {
-        if (i == 0 && s[i] == '-')
-            continue;
-        if (s[i] == '.')
-        {
-            if (dot)
-                return false;
-            dot = true;
-            continue;
-        }
-        if (!isdigit(s[i]))
-            return false;
-    }
-    return true;
-}
-
-double safe_stod(string s)
-{
-    try
-    {
-        if (s.empty() || s == " ")
-            return 0.0;
-        return stod(s);
-    }
-    catch (...)
-    {
-        return 0.0;
-    }
-}
+    double min_x = 1e18, max_x = -1e18, min_y = 1e18, max_y = -1e18;
+};
 
 class Analytics
 {
 public:
+    // One plot label per cluster: 0-9, a-z, A-Z.
+    static const int MAX_CLUSTERS = 62;
+
+    struct Moments
+    {
+        double sx = 0, sy = 0, sxy = 0, sxx = 0, syy = 0;
+    };
+
     static double calculate_correlation(const vector<double> &x, const vector<double> &y)
     {
         if (x.size() != y.size() || x.empty())
             return 0.0;
         double n = x.size();
-        double sum_x = accumulate(x.begin(), x.end(), 0.0);
-        double sum_y = accumulate(y.begin(), y.end(), 0.0);
-        double sum_xy = inner_product(x.begin(), x.end(), y.begin(), 0.0);
-        double sum_x2 = inner_product(x.begin(), x.end(), x.begin(), 0.0);
-        double sum_y2 = inner_product(y.begin(), y.end(), y.begin(), 0.0);
+        Moments m = parallel_reduce(
+            0, x.size(), 1 << 16, Moments(),
+            [&](size_t from, size_t to) {
+                Moments p;
+                for (size_t i = from; i < to; i++)
+                {
+                    p.sx += x[i];
+                    p.sy += y[i];
+                    p.sxy += x[i] * y[i];
+                    p.sxx += x[i] * x[i];
+                    p.syy += y[i] * y[i];
+                }
+                return p;
+            },
+            [](Moments a, const Moments &b) {
+                a.sx += b.sx;
+                a.sy += b.sy;
+                a.sxy += b.sxy;
+                a.sxx += b.sxx;
+                a.syy += b.syy;
+                return a;
+            });
+        double sum_x = m.sx, sum_y = m.sy, sum_xy = m.sxy, sum_x2 = m.sxx, sum_y2 = m.syy;
 
         double num = n * sum_xy - (sum_x * sum_y);
         double den = sqrt((n * sum_x2 - pow(sum_x, 2)) * (n * sum_y2 - pow(sum_y, 2)));
         return (den == 0) ? 0 : num / den;
     }
 
-    static void run_kmeans(const vector<double> &x, const vector<double> &y, int k)
+    // Needs 1 <= k <= min(points, MAX_CLUSTERS); does nothing otherwise.
+    static void run_kmeans(const vector<double> &x, const vector<double> &y, int k, int width = 50, int height = 15)
     {
         int n = x.size();
+        if (k < 1 || k > n || k > MAX_CLUSTERS)
+            return;
         vector<Point> points(n);
+        PlotBounds b; // plot bounds come for free while the points are built
         for (int i = 0; i < n; i++)
+        {
             points[i] = {x[i], y[i], -1};
+            b.min_x = min(b.min_x, x[i]);
+            b.max_x = max(b.max_x, x[i]);
+            b.min_y = min(b.min_y, y[i]);
+            b.max_y = max(b.max_y, y[i]);
+        }
 
         vector<Point> centroids(k);
         for (int i = 0; i < k; i++)
             centroids[i] = points[rand() % n];
 
+        // Assignment and the per-cluster sums are fused into one parallel pass per iteration.
         for (int iter = 0; iter < 50; iter++)
         {
-            for (auto &p : points)
-            {
-                double min_d = 1e18;
-                for (int c = 0; c < k; c++)
-                {
-                    double d = pow(p.x - centroids[c].x, 2) + pow(p.y - centroids[c].y, 2);
-                    if (d < min_d)
+            vector<double> sums = parallel_reduce(
+                0, points.size(), 1 << 14, vector<double>(3 * k, 0.0),
+                [&](size_t from, size_t to) {
+                    vector<double> acc(3 * k, 0.0); // per cluster: sum x, sum y, count
+                    for (size_t i = from; i < to; i++)
                     {
-                        min_d = d;
-                        p.cluster = c;
+                        Point &p = points[i];
+                        double min_d = 1e18;
+                        for (int c = 0; c < k; c++)
+                        {
+                            double dx = p.x - centroids[c].x, dy = p.y - centroids[c].y;
+                            double d = dx * dx + dy * dy;
+                            if (d < min_d)
+                            {
+                                min_d = d;
+                                p.cluster = c;
+                            }
+                        }
+                        acc[3 * p.cluster] += p.x;
+                        acc[3 * p.cluster + 1] += p.y;
+                        acc[3 * p.cluster + 2] += 1;
                     }
-                }
-            }
-            vector<double> sx(k, 0), sy(k, 0);
-            vector<int> counts(k, 0);
-            for (const auto &p : points)
-            {
-                sx[p.cluster] += p.x;
-                sy[p.cluster] += p.y;
-                counts[p.cluster]++;
-            }
+                    return acc;
+                },
+                [](vector<double> a, const vector<double> &b) {
+                    for (size_t i = 0; i < a.size(); i++)
+                        a[i] += b[i];
+                    return a;
+                });
             for (int i = 0; i < k; i++)
-                if (counts[i] > 0)
+                if (sums[3 * i + 2] > 0)
                 {
-                    centroids[i].x = sx[i] / counts[i];
-                    centroids[i].y = sy[i] / counts[i];
+                    centroids[i].x = sums[3 * i] / sums[3 * i + 2];
+                    centroids[i].y = sums[3 * i + 1] / sums[3 * i + 2];
                 }
         }
-        visualize(points);
+        visualize(points, k, b, width, height);
+    }
+
+    static char cluster_label(int c)
+    {
+        static const char LABELS[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        return c >= 0 && c < MAX_CLUSTERS ? LABELS[c] : '#';
     }
 
-    static void visualize(const vector<Point> &points)
+    // Bins points into a width x height density grid in one parallel pass: each
+    // task counts points per (cell, cluster) for its slice and the counts are
+    // summed afterwards. A cell shows its majority cluster; a second panel shows
+    // how many points fell in it. The whole plot goes out as one write.
+    static void visualize(const vector<Point> &points, int k, const PlotBounds &b, int width, int height)
     {
-        const int W = 50, H = 15;
-        vector<vector<char>> grid(H, vector<char>(W, '.'));
-        double min_x = 1e18, max_x = -1e18, min_y = 1e18, max_y = -1e18;
-        for (auto &p : points)
+        int W = max(2, min(width, 200)), H = max(2, min(height, 100));
+        size_t cells = (size_t)W * H;
+        size_t n = points.size();
+        int slices = (int)max((size_t)1, min((size_t)ThreadPool::global().size(), n / 65536));
+        vector<vector<uint32_t>> local(slices);
+        double sx = (W - 1) / (b.max_x - b.min_x + 1e-9), sy = (H - 1) / (b.max_y - b.min_y + 1e-9);
+        parallel_for(0, slices, 1, [&](size_t t, size_t) {
+            vector<uint32_t> &cnt = local[t];
+            cnt.assign(cells * k, 0);
+            for (size_t i = n * t / slices; i < n * (t + 1) / slices; i++)
+            {
+                const Point &p = points[i];
+                int ix = (int)((p.x - b.min_x) * sx), iy = (int)((p.y - b.min_y) * sy);
+                cnt[((size_t)(H - 1 - iy) * W + ix) * k + p.cluster]++;
+            }
+        });
+        for (int t = 1; t < slices; t++)
+            for (size_t c = 0; c < cells * k; c++)
+                local[0][c] += local[t][c];
+        const vector<uint32_t> &cnt = local[0];
+
+        vector<uint64_t> total(cells, 0), perCluster(k, 0);
+        vector<int> major(cells, -1);
+        uint64_t peak = 0;
+        for (size_t c = 0; c < cells; c++)
         {
-            min_x = min(min_x, p.x);
-            max_x = max(max_x, p.x);
-            min_y = min(min_y, p.y);
-            max_y = max(max_y, p.y);
+            uint32_t best = 0;
+            for (int j = 0; j < k; j++)
+            {
+                uint32_t v = cnt[c * k + j];
+                total[c] += v;
+                perCluster[j] += v;
+                if (v > best)
+                {
+                    best = v;
+                    major[c] = j;
+                }
+            }
+            peak = max(peak, total[c]);
         }
-        for (auto &p : points)
+
+        static const char RAMP[] = " .:-=+*#%@";
+        string out;
+        out.reserve((cells + H) * 2 + 256);
+        out += "Majority cluster per cell:\n";
+        for (int r = 0; r < H; r++)
         {
-            int ix = (int)((p.x - min_x) / (max_x - min_x + 1e-9) * (W - 1));
-            int iy = (int)((p.y - min_y) / (max_y - min_y + 1e-9) * (H - 1));
-            grid[H - 1 - iy][ix] = '0' + p.cluster;
+            for (int c = 0; c < W; c++)
+                out += major[r * W + c] < 0 ? '.' : cluster_label(major[r * W + c]);
+            out += '\n';
         }
-        for (auto &row : grid)
+        out += "Points per cell (log scale, max " + to_string(peak) + "):\n";
+        for (int r = 0; r < H; r++)
         {
-            for (char c : row)
-                cout << c;
-            cout << endl;
+            for (int c = 0; c < W; c++)
+            {
+                uint64_t v = total[r * W + c];
+                int level = v == 0 ? 0 : 1 + (int)(8 * log((double)v) / log((double)max<uint64_t>(peak, 2)));
+                out += RAMP[min(level, 9)];
+            }
+            out += '\n';
         }
+        out += "Clusters:";
+        for (int j = 0; j < k; j++)
+            out += string(" ") + cluster_label(j) + "=" + to_string(perCluster[j]);
+        out += '\n';
+        cout.write(out.data(), out.size());
+        cout.flush();
     }
 
     static pair<double, double> run_regression(const vector<double> &x, const vector<double> &y, double split_ratio)
@@ -207,6 +300,68 @@ public:
     }
 };
 
+// Reads one RFC 4180 record; quoted fields may contain commas, doubled quotes and newlines.
+bool read_csv_record(istream &in, vector<string> &r)
+{
+    string line;
+    if (!getline(in, line))
+        return false;
+    r.clear();
+    bool in_q = false;
+    string cur = "";
+    while (true)
+    {
+        for (size_t i = 0; i < line.size(); i++)
+        {
+            char ch = line[i];
+            if (ch == '"')
+            {
+                if (in_q && i + 1 < line.size() && line[i + 1] == '"')
+                {
+                    cur += '"';
+                    i++;
+                }
+                else
+                    in_q = !in_q;
+            }
+            else if (ch == ',' && !in_q)
+            {
+                r.push_back(cur);
+                cur = "";
+            }
+            else if (ch != '\r' || in_q)
+                cur += ch;
+        }
+        if (!in_q || !getline(in, line))
+            break;
+        cur += '\n';
+    }
+    r.push_back(cur);
+    return true;
+}
+
+// Records are parsed into batches and each batch is dictionary-encoded into the
+// table, so only one batch of row strings is held at a time.
+void load_csv(istream &file, vector<string> &head, EncodedTable &data)
+{
+    PROF_SCOPE("load_csv");
+    const size_t BATCH = 65536;
+    read_csv_record(file, head);
+    // Batch rows are reused, so their vectors keep their capacity across batches.
+    vector<vector<string>> batch(BATCH);
+    size_t n = 0;
+    while (read_csv_record(file, batch[n]))
+        if (++n == BATCH)
+        {
+            data.append_rows(batch);
+            n = 0;
+        }
+    batch.resize(n);
+    data.append_rows(batch);
+    data.ensure_columns(head.size());
+    PROF_COUNT("rows loaded", data.size());
+}
+
 void load_dict(Trie &t, string fn)
 {
     ifstream f(fn);
@@ -221,7 +376,7 @@ void load_dict(Trie &t, string fn)
     f.close();
 }
 
-void display_data(const vector<string> &head, const vector<vector<string>> &data)
+void display_data(const vector<string> &head, const EncodedTable &data)
 {
     cout << "\n--- Dataset Preview ---" << endl;
     for (string h : head)
@@ -230,13 +385,16 @@ void display_data(const vector<string> &head, const vector<vector<string>> &data
          << string(head.size() * 15, '-') << endl;
     for (int i = 0; i < min((int)data.size(), 5); i++)
     {
-        for (string cell : data[i])
+        for (size_t j = 0; j < data.width(i); j++)
+        {
+            string cell(data.cell(i, j));
             cout << left << setw(10) << (cell.length() > 14 ? cell.substr(0, 11) + "..." : cell);
+        }
         cout << endl;
     }
 }
 
-void remove_column(vector<string> &head, vector<vector<string>> &data)
+void remove_column(vector<string> &head, EncodedTable &data, ColumnCache &cache)
 {
     cout << "Enter column index to remove or -1: ";
     int rem;
@@ -244,119 +402,453 @@ void remove_column(vector<string> &head, vector<vector<string>> &data)
     if (rem >= 0 && rem < (int)head.size())
     {
         head.erase(head.begin() + rem);
-        for (auto &r : data)
-            if (rem < (int)r.size())
-                r.erase(r.begin() + rem);
+        data.erase_column(rem);
+        cache.erase_column(rem);
         cout << "Column removed successfully." << endl;
     }
 }
 
-void remove_row(vector<vector<string>> &data)
+int compact_rows(EncodedTable &data, const vector<bool> &drop)
+{
+    // Single stable pass per column: surviving codes are moved down over the dropped slots.
+    int removed = count(drop.begin(), drop.end(), true);
+    data.compact(drop);
+    return removed;
+}
+
+// Parses a whole-string row ID; "3x", "" and values outside [0, n) are rejected.
+bool parse_row_id(const string &s, int n, int &id)
+{
+    auto res = from_chars(s.data(), s.data() + s.size(), id);
+    return !s.empty() && res.ec == errc() && res.ptr == s.data() + s.size() && id >= 0 && id < n;
+}
+
+bool parse_row_selection(string spec, int n, vector<bool> &drop)
+{
+    // Accepts comma separated IDs and inclusive ranges, e.g. "3,10-20,42". Nothing is
+    // marked unless the whole selection is valid, so a typo never removes other rows.
+    stringstream ss(spec);
+    string part;
+    vector<pair<int, int>> ranges;
+    while (getline(ss, part, ','))
+    {
+        if (part.empty())
+            continue;
+        size_t dash = part.find('-', 1);
+        int lo, hi;
+        if (!parse_row_id(part.substr(0, dash), n, lo) ||
+            (dash != string::npos && !parse_row_id(part.substr(dash + 1), n, hi)))
+        {
+            cout << "Invalid row selection '" << part << "': IDs must be whole numbers from 0 to " << n - 1
+                 << "." << endl;
+            return false;
+        }
+        if (dash == string::npos)
+            hi = lo;
+        if (lo > hi)
+            swap(lo, hi);
+        ranges.push_back({lo, hi});
+    }
+    if (ranges.empty())
+    {
+        cout << "No rows selected." << endl;
+        return false;
+    }
+    for (auto &r : ranges)
+        for (int i = r.first; i <= r.second; i++)
+            drop[i] = true;
+    return true;
+}
+
+void remove_row(const vector<string> &head, EncodedTable &data, ColumnCache &cache)
 {
-    cout << "Enter Row ID to remove (0 to " << data.size() - 1 << "): ";
-    int idx;
-    cin >> idx;
+    if (data.empty())
+    {
+        cout << "No rows to remove." << endl;
+        return;
+    }
+    cout << "1. By Row IDs / ranges (e.g. 3,10-20)\n2. Rows with a missing value in a column\nChoice: ";
+    int mode;
+    cin >> mode;
 
-    if (idx >= 0 && idx < (int)data.size())
+    vector<bool> drop(data.size(), false);
+    if (mode == 1)
+    {
+        cout << "Enter Row IDs to remove (0 to " << data.size() - 1 << "): ";
+        string spec;
+        cin >> spec;
+        if (!parse_row_selection(spec, data.size(), drop))
+            return;
+    }
+    else if (mode == 2)
     {
-        data.erase(data.begin() + idx);
-        cout << "Row " << idx << " deleted." << endl;
+        cout << "Select Column (0-" << head.size() - 1 << "): ";
+        int sel;
+        cin >> sel;
+        if (sel < 0 || sel >= (int)head.size())
+        {
+            cout << "Invalid column!" << endl;
+            return;
+        }
+        for (int i = 0; i < (int)data.size(); i++)
+        {
+            string_view cell = data.cell(i, sel);
+            drop[i] = sel >= (int)data.width(i) || cell.empty() || cell == " ";
+        }
     }
     else
     {
-        cout << "Invalid Row ID." << endl;
+        cout << "Invalid choice!" << endl;
+        return;
     }
+
+    int removed = compact_rows(data, drop);
+    cache.remove_rows(drop);
+    cout << removed << " row(s) deleted. New row count: " << data.size() << endl;
 }
 
-void handle_duplicates(vector<vector<string>> &data)
+// Marks every row that repeats an earlier one; the first occurrence of each group survives.
+// Rows are hashed and compared on their width and dictionary codes, never on the strings.
+int find_duplicates(const EncodedTable &enc, vector<bool> &drop)
 {
-    cout << "Scanning for duplicates..." << endl;
-    Hash h_map(data.size() * 2);
-    UnionFind dsu(data.size());
+    PROF_SCOPE("find_duplicates");
+    int n = enc.rows();
+    UnionFind dsu(n);
     int d_cnt = 0;
 
-    for (int i = 0; i < (int)data.size(); i++)
+    size_t cap = 16;
+    while (cap < (size_t)n * 2)
+        cap <<= 1;
+    vector<int> slots(cap, -1);
+    vector<uint64_t> slotHash(cap);
+    vector<uint64_t> rowHash(n);
+    parallel_for(0, n, 1 << 14, [&](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++)
+            rowHash[i] = enc.row_hash(i);
+    });
+    for (int i = 0; i < n; i++)
     {
-        string key = "";
-        for (string s : data[i])
-            key += s + "|";
-        int match = h_map.get(key);
-        if (match != -1)
+        uint64_t h = rowHash[i];
+        size_t p = h & (cap - 1);
+        while (slots[p] != -1 && !(slotHash[p] == h && enc.rows_equal(slots[p], i)))
+            p = (p + 1) & (cap - 1);
+        if (slots[p] != -1)
         {
-            dsu.unite(i, match);
+            dsu.unite(i, slots[p]);
             d_cnt++;
         }
         else
         {
-            h_map.add(key, i);
+            slots[p] = i;
+            slotHash[p] = h;
         }
     }
 
+    vector<bool> seen(n, false);
+    drop.assign(n, false);
+    for (int i = 0; i < n; i++)
+    {
+        int root = dsu.find(i);
+        if (seen[root])
+            drop[i] = true;
+        seen[root] = true;
+    }
+    return d_cnt;
+}
+
+void handle_duplicates(EncodedTable &data, ColumnCache &cache)
+{
+    cout << "Scanning for duplicates..." << endl;
+    vector<bool> drop;
+    int d_cnt = find_duplicates(data, drop);
+
     cout << "Duplicates found: " << d_cnt << ". Merge unique rows? (1:Yes, 0:No): ";
     int choice;
     cin >> choice;
     if (choice == 1)
     {
-        vector<vector<string>> clean;
-        vector<bool> seen(data.size(), false);
-        for (int i = 0; i < (int)data.size(); i++)
+        compact_rows(data, drop);
+        cache.remove_rows(drop);
+        cout << "Duplicates removed. New row count: " << data.size() << endl;
+    }
+}
+
+enum ImputeStrategy
+{
+    IMPUTE_MEAN,
+    IMPUTE_MEDIAN,
+    IMPUTE_MODE
+};
+
+struct ImputeSpec
+{
+    ImputeStrategy strategy = IMPUTE_MEAN;
+    vector<int> groupBy; // column indexes; empty means one global group
+};
+
+struct ImputeResult
+{
+    long long filled = 0;
+    bool numeric = false;
+};
+
+bool is_missing(string_view cell)
+{
+    return cell.empty() || cell == " ";
+}
+
+string format_double(double v)
+{
+    char buf[32];
+    auto res = to_chars(buf, buf + sizeof(buf), v);
+    return string(buf, res.ptr);
+}
+
+// Gives every row a dense group id from the group-by key columns in one hash
+// pass; the key is the row's codes in those columns.
+int build_groups(const EncodedTable &data, const vector<int> &cols, vector<int> &gid)
+{
+    gid.assign(data.size(), 0);
+    if (cols.empty())
+        return 1;
+    unordered_map<string, int> ids;
+    string key;
+    for (int i = 0; i < (int)data.size(); i++)
+    {
+        key.clear();
+        for (int c : cols)
         {
-            int root = dsu.find(i);
-            if (!seen[root])
-            {
-                clean.push_back(data[i]);
-                seen[root] = true;
-            }
+            uint32_t code = data.column(c).codes[i];
+            key.append((const char *)&code, sizeof(code));
         }
-        data = clean;
-        cout << "Duplicates removed. New row count: " << data.size() << endl;
+        gid[i] = ids.emplace(key, (int)ids.size()).first->second;
     }
+    return ids.size();
 }
 
-void impute_missing(const vector<string> &head, vector<vector<string>> &data)
+// Median by selection: nth_element is O(n) on average, no full sort.
+double median_of(vector<double> &v)
 {
-    cout << "Imputing missing numeric values..." << endl;
-    for (int j = 0; j < (int)head.size(); j++)
+    size_t mid = v.size() / 2;
+    nth_element(v.begin(), v.begin() + mid, v.end());
+    double hi = v[mid];
+    if (v.size() % 2 == 1)
+        return hi;
+    double lo = *max_element(v.begin(), v.begin() + mid);
+    return (lo + hi) / 2;
+}
+
+// Fills one column. Every distinct value is parsed once; per-group statistics
+// are gathered in a single pass, with slot `groups` holding the global fallback
+// for groups that have no values of their own. Text columns are only filled by
+// the mode strategy; mean and median leave them untouched, as the streaming
+// pipeline does.
+ImputeResult impute_column(EncodedTable &data, int j, const ImputeSpec &spec, const vector<int> &gid, int groups)
+{
+    ImputeResult res;
+    int n = data.size();
+    const EncodedColumn &col = data.column(j);
+    vector<char> missingCode(col.dict.size());
+    vector<ParsedNum> parsed(col.dict.size());
+    for (uint32_t c = 0; c < col.dict.size(); c++)
     {
-        double sum = 0;
-        int cnt = 0;
-        for (int i = 0; i < (int)data.size(); i++)
+        missingCode[c] = is_missing(col.dict.decode(c));
+        if (!missingCode[c])
+            parsed[c] = parse_number(col.dict.decode(c));
+    }
+    vector<char> miss(n, 0);
+    long long present = 0, absent = 0;
+    res.numeric = true;
+    for (int i = 0; i < n; i++)
+    {
+        if (j >= (int)data.width(i))
+            continue;
+        uint32_t c = col.codes[i];
+        if (missingCode[c])
+        {
+            miss[i] = 1;
+            absent++;
+            continue;
+        }
+        present++;
+        if (!parsed[c].ok())
+            res.numeric = false;
+    }
+    auto value = [&](int i) { return parsed[col.codes[i]].value; };
+    if (present == 0 || absent == 0 || (!res.numeric && spec.strategy != IMPUTE_MODE))
+        return res;
+
+    ImputeStrategy strategy = spec.strategy;
+    vector<string> fill(groups + 1);
+    auto present_rows = [&](auto fn) {
+        for (int i = 0; i < n; i++)
+            if (!miss[i] && j < (int)data.width(i))
+                fn(i);
+    };
+
+    if (strategy == IMPUTE_MEAN)
+    {
+        vector<double> sum(groups + 1, 0);
+        vector<long long> cnt(groups + 1, 0);
+        present_rows([&](int i) {
+            sum[gid[i]] += value(i);
+            cnt[gid[i]]++;
+            sum[groups] += value(i);
+            cnt[groups]++;
+        });
+        for (int g = 0; g <= groups; g++)
+            if (cnt[g] > 0)
+                fill[g] = format_double(sum[g] / cnt[g]);
+    }
+    else if (strategy == IMPUTE_MEDIAN)
+    {
+        vector<vector<double>> bucket(groups + 1);
+        present_rows([&](int i) {
+            bucket[gid[i]].push_back(value(i));
+            bucket[groups].push_back(value(i));
+        });
+        for (int g = 0; g <= groups; g++)
+            if (!bucket[g].empty())
+                fill[g] = format_double(median_of(bucket[g]));
+    }
+    else
+    {
+        vector<unordered_map<uint32_t, int>> freq(groups + 1);
+        present_rows([&](int i) {
+            freq[gid[i]][col.codes[i]]++;
+            freq[groups][col.codes[i]]++;
+        });
+        for (int g = 0; g <= groups; g++)
         {
-            if (is_num(data[i][j]))
+            int best = 0;
+            for (auto &kv : freq[g])
             {
-                sum += safe_stod(data[i][j]);
-                cnt++;
+                string_view v = col.dict.decode(kv.first);
+                if (kv.second > best || (kv.second == best && v < fill[g]))
+                {
+                    best = kv.second;
+                    fill[g] = string(v);
+                }
             }
         }
+    }
 
-        if (cnt > 0)
+    for (int i = 0; i < n; i++)
+        if (miss[i])
         {
-            string avg = to_string(sum / cnt);
-            for (int i = 0; i < (int)data.size(); i++)
-                if (data[i][j] == "" || data[i][j] == " ")
-                    data[i][j] = avg;
+            data.set(i, j, fill[gid[i]].empty() ? fill[groups] : fill[gid[i]]);
+            res.filled++;
         }
-    }
+    return res;
+}
+
+// Columns are independent, so each one is a separate task on the pool.
+// Group-by key columns are left untouched since every worker reads them.
+// Columns that received values are bumped in `cache` when one is given.
+void impute_missing(const vector<string> &head, EncodedTable &data, const ImputeSpec &spec,
+                    ColumnCache *cache = nullptr)
+{
+    PROF_SCOPE("impute_missing");
+    static const char *NAMES[] = {"mean", "median", "mode"};
+    cout << "Imputing missing values (" << NAMES[spec.strategy] << (spec.groupBy.empty() ? "" : ", grouped") << ")..."
+         << endl;
+    vector<int> gid;
+    int groups = build_groups(data, spec.groupBy, gid);
+
+    vector<int> cols;
+    for (int j = 0; j < (int)head.size(); j++)
+        if (find(spec.groupBy.begin(), spec.groupBy.end(), j) == spec.groupBy.end())
+            cols.push_back(j);
+
+    vector<ImputeResult> results(head.size());
+    parallel_for(0, cols.size(), 1, [&](size_t from, size_t to) {
+        for (size_t k = from; k < to; k++)
+            results[cols[k]] = impute_column(data, cols[k], spec, gid, groups);
+    });
+
+    for (int j : cols)
+        if (results[j].filled > 0 && cache)
+            cache->bump(j);
+    for (int j : cols)
+        if (results[j].filled > 0)
+            cout << head[j] << ": " << results[j].filled << " filled ("
+                 << NAMES[spec.strategy] << ")" << endl;
     cout << "Done." << endl;
 }
 
-void show_priority_rows(const vector<string> &head, vector<vector<string>> &data, Trie &dict)
+void impute_menu(const vector<string> &head, EncodedTable &data, ColumnCache &cache)
 {
-    vector<pair<int, int>> row_scores; 
-    for (int i = 0; i < (int)data.size(); i++)
+    cout << "Strategy (1: Mean, 2: Median, 3: Mode): ";
+    int st;
+    cin >> st;
+    if (st < 1 || st > 3)
     {
-        int score = 0;
-        for (int j = 0; j < (int)head.size(); j++)
+        cout << "Invalid choice!" << endl;
+        return;
+    }
+    ImputeSpec spec;
+    spec.strategy = (ImputeStrategy)(st - 1);
+    cout << "Group by column indexes (e.g. 2,4 or - for none): ";
+    string cols;
+    cin >> cols;
+    if (cols != "-")
+    {
+        stringstream ss(cols);
+        string c;
+        while (getline(ss, c, ','))
         {
-            if (data[i][j].empty() || data[i][j] == " ")
-                score += 2;
-            else if (!is_num(data[i][j]) && !dict.search(data[i][j]))
-                score += 1;
+            int idx;
+            if (!parse_row_id(c, head.size(), idx))
+            {
+                cout << "Invalid column!" << endl;
+                return;
+            }
+            spec.groupBy.push_back(idx);
         }
-        row_scores.push_back({score, i});
     }
+    impute_missing(head, data, spec, &cache);
+}
+
+// Returns {dirty score, row} pairs, dirtiest first. Each distinct value is scored
+// once per column (number check, dictionary lookup); rows just sum code scores.
+vector<pair<int, int>> score_rows(const vector<string> &head, const EncodedTable &enc, Trie &dict)
+{
+    PROF_SCOPE("score_rows");
+    int n = enc.rows();
+    int m = head.size();
+    vector<vector<uint8_t>> codeScore(m);
+    parallel_for(0, m, 1, [&](size_t from, size_t to) {
+        for (size_t j = from; j < to; j++)
+        {
+            const EncodedColumn &col = enc.column(j);
+            codeScore[j].assign(col.dict.size(), 0);
+            for (uint32_t c = 0; c < col.dict.size(); c++)
+            {
+                string v(col.dict.decode(c));
+                if (is_missing(v))
+                    codeScore[j][c] = 2;
+                else if (!parse_number(v).ok() && !dict.search(v))
+                    codeScore[j][c] = 1;
+            }
+        }
+    });
+    vector<pair<int, int>> row_scores(n);
+    parallel_for(0, n, 1 << 14, [&](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++)
+        {
+            int score = 0;
+            for (int j = 0; j < m; j++)
+                score += codeScore[j][enc.column(j).codes[i]];
+            row_scores[i] = {score, (int)i};
+        }
+    });
 
     sort(row_scores.rbegin(), row_scores.rend());
+    return row_scores;
+}
+
+void print_priority_rows(const vector<pair<int, int>> &row_scores)
+{
     cout << "\n--- Top 5 Rows Needing Attention ---" << endl;
     for (int i = 0; i < min(5, (int)row_scores.size()); i++)
     {
@@ -365,116 +857,344 @@ void show_priority_rows(const vector<string> &head, vector<vector<string>> &data
             cout << "Original Row " << row_scores[i].second << " | Dirty Score: " << row_scores[i].first << endl;
         }
     }
+}
+
+void show_priority_rows(const vector<string> &head, EncodedTable &data, Trie &dict, ColumnCache &cache)
+{
+    vector<pair<int, int>> row_scores = score_rows(head, data, dict);
+    print_priority_rows(row_scores);
     cout << "\nWould you like to sort the dataset to bring these errors to the top? (1:Yes, 0:No): ";
     int choice;
     cin >> choice;
 
     if (choice == 1)
     {
-        vector<vector<string>> sorted_data;
+        vector<int> order;
         for (auto &p : row_scores)
         {
-            sorted_data.push_back(data[p.second]);
+            order.push_back(p.second);
         }
-        data = sorted_data; 
+        data.reorder(order);
+        cache.bump_all();
         cout << "Dataset sorted! The dirtiest rows are now at the top." << endl;
     }
 }
-void save_data(const vector<string> &head, const vector<vector<string>> &data, string filename)
+bool save_data(const vector<string> &head, const EncodedTable &data, string filename)
 {
-    ofstream file(filename);
+    PROF_SCOPE("save_data");
+    CsvWriter file(filename);
     if (!file.is_open())
     {
         cout << "Error: Could not write to file!" << endl;
-        return;
-    }
-    for (int i = 0; i < head.size(); i++)
-    {
-        file << head[i] << (i == head.size() - 1 ? "" : ",");
+        return false;
     }
-    file << "\n";
-
-    for (const auto &row : data)
+    file.write_row(head);
+    file.write_rows(data);
+    if (!file.close())
     {
-        for (int i = 0; i < row.size(); i++)
-        {
-            if (row[i].find(',') != string::npos)
-                file << "\"" << row[i] << "\"";
-            else
-                file << row[i];
-
-            file << (i == row.size() - 1 ? "" : ",");
-        }
-        file << "\n";
+        cout << "Error: Writing " << filename << " failed; the file is incomplete." << endl;
+        return false;
     }
-    file.close();
-    cout << "Data successfully saved to " << filename << endl;
+    PROF_COUNT("bytes written", file.bytes_written());
+    cout << "Data successfully saved to " << filename << " (" << file.bytes_written() << " bytes)" << endl;
+    return true;
 }
-void perform_analytics(const vector<string> &head, const vector<vector<string>> &data)
+bool save_snapshot(const vector<string> &head, const EncodedTable &data, string filename)
 {
-    cout << "1. Correlation Matrix\n2. K-Means Clustering\n3. Regression\nChoice: ";
-    int ch;
-    cin >> ch;
-    vector<int> nums;
-    for (int i = 0; i < head.size(); i++)
-        if (!data.empty() && is_num(data[0][i]))
-            nums.push_back(i);
-
-    if (ch == 1)
+    PROF_SCOPE("save_snapshot");
+    SnapshotWriter file(filename, data.size());
+    if (!file.is_open())
     {
-        for (int i : nums)
+        cout << "Error: Could not write to file!" << endl;
+        return false;
+    }
+    enum CodeKind : uint8_t
+    {
+        UNSEEN,
+        EMPTY_CELL,
+        NUMBER,
+        TEXT
+    };
+    for (int j = 0; j < (int)head.size(); j++)
+    {
+        // Each distinct value is classified once. Numbers that would not print back
+        // as written ("007", "1.50", "1e5") keep the column as text.
+        const EncodedColumn &col = data.column(j);
+        vector<uint8_t> kind(col.dict.size(), UNSEEN);
+        vector<double> codeVal(col.dict.size(), 0.0);
+        vector<bool> nulls(data.size());
+        vector<double> vals(data.size(), 0.0);
+        bool numeric = false, text = false;
+        for (int i = 0; i < (int)data.size(); i++)
         {
-            cout << head[i].substr(0, 5) << " | ";
-            for (int j : nums)
+            uint32_t c = col.codes[i];
+            if (kind[c] == UNSEEN)
             {
-                vector<double> vx, vy;
-                for (auto &r : data)
-                {
-                    vx.push_back(safe_stod(r[i]));
-                    vy.push_back(safe_stod(r[j]));
-                }
-                cout << setw(8) << Analytics::calculate_correlation(vx, vy);
+                string_view cell = col.dict.decode(c);
+                ParsedNum num = parse_number(cell);
+                kind[c] = cell.empty() ? EMPTY_CELL
+                          : num.ok() && SnapshotReader::format_number(num.value) == cell ? NUMBER
+                                                                                           : TEXT;
+                codeVal[c] = num.value;
             }
-            cout << endl;
+            nulls[i] = kind[c] == EMPTY_CELL;
+            vals[i] = codeVal[c];
+            numeric = numeric || kind[c] == NUMBER;
+            text = text || kind[c] == TEXT;
         }
+
+        if (numeric && !text)
+            file.add_numeric(head[j], vals, nulls);
+        else
+            file.add_string(head[j], col, nulls);
     }
-    else if (ch == 2)
+    if (!file.finish())
     {
-        cout << "X col index: ";
-        int x;
-        cin >> x;
-        cout << "Y col index: ";
-        int y;
-        cin >> y;
-        vector<double> vx, vy;
-        for (auto &r : data)
-        {
-            vx.push_back(safe_stod(r[x]));
-            vy.push_back(safe_stod(r[y]));
-        }
-        Analytics::run_kmeans(vx, vy, 3);
+        cout << "Error: Writing " << filename << " failed; the file is incomplete." << endl;
+        return false;
     }
-    else if (ch == 3)
+    cout << "Snapshot successfully saved to " << filename << endl;
+    return true;
+}
+
+void show_snapshot_stats(const SnapshotReader &snap)
+{
+    cout << "\n--- Snapshot Column Stats ---" << endl;
+    for (int c = 0; c < snap.columns(); c++)
     {
-        cout << "\nAvailable Numeric Columns:\n";
-        for (int i : nums)
-            cout << i << ": " << head[i] << endl;
-        cout << "Select Independent Variable (X): ";
-        int x;
+        const SnapColumn &m = snap.meta(c);
+        cout << left << setw(12) << snap.name(c) << " | Count: " << m.count;
+        if (m.type == SNAP_NUMERIC)
+            cout << " | Min: " << m.minVal << " | Max: " << m.maxVal << endl;
+        else
+            cout << " | Distinct: " << snap.distinct(c) << endl;
+    }
+}
+
+int resolve_column(const vector<string> &head, const string &name)
+{
+    auto it = find(head.begin(), head.end(), name);
+    if (it != head.end())
+        return it - head.begin();
+    if (!name.empty() && all_of(name.begin(), name.end(), ::isdigit))
+    {
+        int idx = atoi(name.c_str());
+        if (idx < (int)head.size())
+            return idx;
+    }
+    return -1;
+}
+
+// "<key cols>:<aggregates>", e.g. "Pclass,Sex:count,mean(Fare),distinct(Ticket)".
+// Columns may be given by name or index.
+bool parse_groupby(const string &spec, const vector<string> &head, vector<int> &keys, vector<AggSpec> &aggs,
+                   vector<string> &labels)
+{
+    static const pair<const char *, AggOp> OPS[] = {{"count", AGG_COUNT}, {"sum", AGG_SUM},  {"mean", AGG_MEAN},
+                                                    {"min", AGG_MIN},     {"max", AGG_MAX},  {"distinct", AGG_DISTINCT}};
+    size_t colon = spec.find(':');
+    if (colon == string::npos)
+        return false;
+    stringstream ks(spec.substr(0, colon)), as(spec.substr(colon + 1));
+    string item;
+    while (getline(ks, item, ','))
+    {
+        int c = resolve_column(head, item);
+        if (c < 0)
+            return false;
+        keys.push_back(c);
+    }
+    while (getline(as, item, ','))
+    {
+        size_t open = item.find('('), close = item.find(')');
+        string op = item.substr(0, open);
+        AggSpec agg{AGG_COUNT, -1};
+        bool known = false;
+        for (auto &o : OPS)
+            if (op == o.first)
+            {
+                agg.op = o.second;
+                known = true;
+            }
+        if (!known)
+            return false;
+        if (agg.op != AGG_COUNT)
+        {
+            if (open == string::npos || close == string::npos || close < open)
+                return false;
+            agg.col = resolve_column(head, item.substr(open + 1, close - open - 1));
+            if (agg.col < 0)
+                return false;
+        }
+        aggs.push_back(agg);
+        labels.push_back(agg.op == AGG_COUNT ? "count" : op + "(" + head[agg.col] + ")");
+    }
+    return !keys.empty() && !aggs.empty();
+}
+
+bool run_groupby(const vector<string> &head, const EncodedTable &data, const string &spec)
+{
+    PROF_SCOPE("groupby");
+    vector<int> keys;
+    vector<AggSpec> aggs;
+    vector<string> labels;
+    if (!parse_groupby(spec, head, keys, aggs, labels))
+    {
+        cout << "Invalid group-by spec: " << spec << endl;
+        return false;
+    }
+
+    const int LIMIT = 50;
+    GroupBy gb(keys, aggs);
+    vector<pair<vector<string>, vector<double>>> groups;
+    long long total = 0;
+    gb.run(data, [&](const vector<string> &key, const vector<double> &vals) {
+        // Spilled runs can have huge key counts, so only keep what is shown.
+        if (!gb.spilled || (int)groups.size() < LIMIT)
+            groups.push_back({key, vals});
+        total++;
+    });
+    if (!gb.spilled)
+        sort(groups.begin(), groups.end());
+
+    cout << "\n--- Group By ---" << endl;
+    for (int k : keys)
+        cout << left << setw(14) << head[k].substr(0, 13);
+    for (const string &l : labels)
+        cout << right << setw(16) << l.substr(0, 15);
+    cout << endl;
+    for (int g = 0; g < (int)groups.size() && g < LIMIT; g++)
+    {
+        for (const string &k : groups[g].first)
+            cout << left << setw(14) << (k.empty() ? "(empty)" : k.substr(0, 13));
+        for (double v : groups[g].second)
+            cout << right << setw(16) << v;
+        cout << endl;
+    }
+    cout << total << " group(s)" << (total > LIMIT ? ", first 50 shown" : "")
+         << (gb.spilled ? " [spilled to disk]" : "") << (gb.spillFailed ? " [could not spill, grouped in memory]" : "")
+         << endl;
+    return true;
+}
+
+void groupby_menu(const vector<string> &head, const EncodedTable &data)
+{
+    cout << "Columns: ";
+    for (int i = 0; i < (int)head.size(); i++)
+        cout << i << ":" << head[i] << " ";
+    cout << "\nGroup by (e.g. Pclass,Sex:count,mean(Fare),max(Age),distinct(Ticket)): ";
+    string spec;
+    cin >> spec;
+    run_groupby(head, data, spec);
+}
+
+// Collects (x, y) for rows where both cells are numbers; blanks and text are skipped, not read as 0.
+void numeric_pairs(const EncodedTable &data, int x, int y, vector<double> &vx, vector<double> &vy)
+{
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        if (x >= (int)data.width(i) || y >= (int)data.width(i))
+            continue;
+        ParsedNum px = parse_number(data.cell(i, x)), py = parse_number(data.cell(i, y));
+        if (px.ok() && py.ok())
+        {
+            vx.push_back(px.value);
+            vy.push_back(py.value);
+        }
+    }
+}
+
+void perform_analytics(const vector<string> &head, const EncodedTable &data, ColumnCache &cache)
+{
+    cout << "1. Correlation Matrix\n2. K-Means Clustering\n3. Regression\nChoice: ";
+    int ch;
+    cin >> ch;
+    vector<int> nums;
+    for (int i = 0; i < head.size(); i++)
+        if (!data.empty() && parse_number(data.cell(0, i)).ok())
+            nums.push_back(i);
+
+    if (ch == 1)
+    {
+        // Cells whose columns are unchanged since the last run come from the cache;
+        // the rest are independent tasks. The matrix is symmetric.
+        int m = nums.size();
+        vector<double> corr(m * m, 1.0);
+        vector<pair<int, int>> cells;
+        for (int a = 0; a < m; a++)
+            for (int b = a; b < m; b++)
+            {
+                double r;
+                if (cache.cached_correlation(nums[a], nums[b], r))
+                    corr[a * m + b] = corr[b * m + a] = r;
+                else
+                    cells.push_back({a, b});
+            }
+        cache.prepare_numeric(data, nums);
+        parallel_for(0, cells.size(), 1, [&](size_t from, size_t to) {
+            for (size_t c = from; c < to; c++)
+            {
+                int a = cells[c].first, b = cells[c].second;
+                vector<double> vx, vy;
+                cache.numeric_pairs(data, nums[a], nums[b], vx, vy);
+                corr[a * m + b] = corr[b * m + a] = Analytics::calculate_correlation(vx, vy);
+            }
+        });
+        for (auto &c : cells)
+            cache.store_correlation(nums[c.first], nums[c.second], corr[c.first * m + c.second]);
+        for (int a = 0; a < m; a++)
+        {
+            cout << head[nums[a]].substr(0, 5) << " | ";
+            for (int b = 0; b < m; b++)
+                cout << setw(8) << corr[a * m + b];
+            cout << endl;
+        }
+    }
+    else if (ch == 2)
+    {
+        cout << "X col index: ";
+        int x;
         cin >> x;
-        cout << "Select Dependent Variable (Y to predict): ";
+        cout << "Y col index: ";
         int y;
         cin >> y;
-
         vector<double> vx, vy;
-        for (auto &r : data)
+        if (x >= 0 && x < (int)head.size() && y >= 0 && y < (int)head.size())
+            cache.numeric_pairs(data, x, y, vx, vy);
+        if (vx.empty())
         {
-            if (is_num(r[x]) && is_num(r[y]))
-            {
-                vx.push_back(safe_stod(r[x]));
-                vy.push_back(safe_stod(r[y]));
-            }
+            cout << "No numeric rows in these columns!" << endl;
+            return;
         }
+        cout << "Number of clusters (k): ";
+        int k = 0;
+        cin >> k;
+        cout << "Plot width and height (e.g. 50 15): ";
+        int w = 0, h = 0;
+        cin >> w >> h;
+        if (k < 1 || k > Analytics::MAX_CLUSTERS || k > (int)vx.size() || w < 2 || h < 2)
+        {
+            cout << "Invalid plot settings! k must be between 1 and " << min<size_t>(Analytics::MAX_CLUSTERS, vx.size())
+                 << "." << endl;
+            return;
+        }
+        Analytics::run_kmeans(vx, vy, k, w, h);
+    }
+    else if (ch == 3)
+    {
+        cout << "\nAvailable Numeric Columns:\n";
+        for (int i : nums)
+            cout << i << ": " << head[i] << endl;
+        cout << "Select Independent Variable (X): ";
+        int x;
+        cin >> x;
+        cout << "Select Dependent Variable (Y to predict): ";
+        int y;
+        cin >> y;
+
+        vector<double> vx, vy;
+        if (x >= 0 && x < (int)head.size() && y >= 0 && y < (int)head.size())
+            cache.numeric_pairs(data, x, y, vx, vy);
 
         cout << "Enter Train Ratio (e.g., 0.8): ";
         double ratio;
@@ -499,24 +1219,27 @@ void perform_analytics(const vector<string> &head, const vector<vector<string>>
     }
 }
 
-void filter_data(const vector<string> &head, const vector<vector<string>> &data)
+void filter_data(const vector<string> &head, const EncodedTable &data, ColumnCache &cache)
 {
     cout << "Select Numeric Column to Filter (0-" << head.size() - 1 << "): ";
     int sel;
     cin >> sel;
 
-    if (sel < 0 || sel >= (int)head.size() || !is_num(data[0][sel]))
+    if (sel < 0 || sel >= (int)head.size() || data.empty() || !parse_number(data.cell(0, sel)).ok())
     {
         cout << "Invalid or Non-numeric column!" << endl;
         return;
     }
 
-    AVLTree tree;
-    cout << "Building Index (AVL Tree)..." << endl;
-    for (int i = 0; i < (int)data.size(); i++)
+    // The AVL index is kept until the column changes, so repeated filters skip the build.
+    AVLTree *index;
     {
-        tree.add(safe_stod(data[i][sel]), i);
+        PROF_SCOPE("avl_build");
+        index = &cache.ordered(data, sel);
     }
+    AVLTree &tree = *index;
+    ArenaStats mem = tree.memory_stats();
+    cout << "Index ready: " << mem.objects << " nodes, " << mem.reserved / 1024 << " KB" << endl;
 
     double minV, maxV;
     cout << "Enter Minimum Value: ";
@@ -528,145 +1251,1441 @@ void filter_data(const vector<string> &head, const vector<vector<string>> &data)
     tree.query(tree.root, minV, maxV, data);
 }
 
-void analyze_column(const vector<string> &head, const vector<vector<string>> &data, Trie &dict)
+void print_sketch(const string &name, const ColumnSketch &sk)
+{
+    cout << left << setw(12) << name.substr(0, 11) << " | Rows: " << sk.rows << " | Nulls: " << sk.nulls
+         << " | Distinct: " << sk.distinct << " | Top:";
+    int shown = 0;
+    for (auto &e : sk.top)
+    {
+        if (e.count < 2 || shown == 3)
+            break;
+        cout << " " << (e.item.size() > 12 ? e.item.substr(0, 9) + "..." : e.item) << " (" << e.count << ")";
+        shown++;
+    }
+    if (shown == 0)
+        cout << " (no repeated values)";
+    cout << endl;
+}
+
+void analyze_column(const vector<string> &head, const EncodedTable &data, Trie &dict,
+                    ColumnCache &cache)
 {
-    cout << "Select Column (0-" << head.size() - 1 << "): ";
+    cout << "Select Column (0-" << head.size() - 1 << ", -1 for an overview of all columns): ";
     int sel;
     cin >> sel;
+    if (sel == -1)
+    {
+        cout << "\n--- Column Overview ---" << endl;
+        for (int j = 0; j < (int)head.size(); j++)
+            print_sketch(head[j], cache.sketch(data, j));
+        return;
+    }
     if (sel < 0 || sel >= (int)head.size())
         return;
+    print_sketch(head[sel], cache.sketch(data, sel));
 
-    if (is_num(data[0][sel]))
+    if (!data.empty() && parse_number(data.cell(0, sel)).ok())
     {
 
-        vector<double> nums;
-        for (auto &r : data)
-            nums.push_back(safe_stod(r[sel]));
-        SegmentTree st(nums);
-        Node res = st.getFullStats();
+        PROF_SCOPE("segment_tree_build");
+        const Node &res = cache.stats(data, sel);
         cout << "Sum: " << res.sum << " | Min: " << res.minVal << " | Max: " << res.maxVal << endl;
     }
     else
     {
 
         cout << "Checking for typos..." << endl;
+        // Look each distinct value up once; rows then only index the result by code.
+        const EncodedColumn &col = data.column(sel);
+        vector<char> typo(col.dict.size(), 0);
+        vector<string> hint(col.dict.size());
+        for (uint32_t c = 0; c < col.dict.size(); c++)
+        {
+            string v(col.dict.decode(c));
+            if (v.empty() || dict.search(v))
+                continue;
+            typo[c] = 1;
+            vector<string> sug = dict.suggest(v.substr(0, 3));
+            if (!sug.empty())
+                hint[c] = sug[0];
+        }
         for (int i = 0; i < (int)data.size(); i++)
         {
-            if (!data[i][sel].empty() && !dict.search(data[i][sel]))
+            uint32_t c = col.codes[i];
+            if (typo[c])
             {
-                cout << "Row " << i << ": " << data[i][sel];
-                vector<string> sug = dict.suggest(data[i][sel].substr(0, 3));
-                if (!sug.empty())
-                    cout << " -> Try: " << sug[0];
+                cout << "Row " << i << ": " << col.dict.decode(c);
+                if (!hint[c].empty())
+                    cout << " -> Try: " << hint[c];
                 cout << endl;
             }
         }
     }
 }
 
-int main()
+struct StreamChunk
 {
-    Trie dict;
-    load_dict(dict, "google-10000-english.txt");
-    cout << "Enter the Filename : ";
-    string fn;
-    cin >> fn;
-    ifstream file(fn);
-    if (!file.is_open())
+    vector<long long> ids;
+    vector<vector<string>> rows;
+};
+
+struct StreamOptions
+{
+    vector<string> dropCols;
+    bool impute = false;
+    bool dedup = false;
+    bool score = true;
+    bool save = true; // without it rows are only counted; dedup still spills next to `output`
+    string output = "cleaned_data.csv";
+    int chunkRows = 16384;
+    int queueDepth = 4;
+    size_t memBudget = (size_t)256 << 20;
+};
+
+// Streaming duplicate filter. Row keys stay in memory until the budget is hit;
+// after that, rows not already known are spilled to hash partitions on disk and
+// deduplicated one partition at a time once the input ends. Spilled rows are
+// therefore written after the in-memory ones.
+// A partition that would not fit the budget is split 16 ways again by another
+// slice of the row hash (up to MAX_SPLIT levels), so memory stays near the
+// budget however many distinct rows there are.
+// If a spill file cannot be written or read back, failed() is set and the
+// output must be treated as incomplete.
+class StreamDedup
+{
+private:
+    static const int MAX_SPLIT = 3;
+    unordered_set<string> seen;
+    size_t used, budget;
+    string prefix;
+    vector<ofstream> spill;
+    vector<size_t> spillBytes;
+    vector<long long> spillRows;
+    long long spilled;
+    bool spillFailed;
+
+    static string row_key(const vector<string> &r, size_t from = 0)
     {
-        cout << "Could not open " << fn << endl;
-        return 1;
+        string key;
+        for (size_t i = from; i < r.size(); i++)
+        {
+            key += r[i];
+            key += '\x1f';
+        }
+        return key;
     }
 
-    vector<string> head;
-    vector<vector<string>> data;
-    string line;
+    // Estimated memory for a partition's keys, matching the accounting in admit().
+    static size_t estimate(size_t bytes, long long rows) { return bytes + rows * 64; }
 
-    if (getline(file, line))
+    void emit(StreamChunk &chunk, BoundedQueue<StreamChunk> &out, int chunkRows)
     {
-        stringstream ss(line);
-        string c;
-        while (getline(ss, c, ','))
-            head.push_back(c);
+        if ((int)chunk.rows.size() < chunkRows)
+            return;
+        out.push(move(chunk));
+        chunk = StreamChunk();
     }
 
-    while (getline(file, line))
+    void drain_file(const string &name, size_t bytes, long long rows, int depth, BoundedQueue<StreamChunk> &out,
+                    int chunkRows)
     {
+        ifstream in(name, ios::binary);
+        if (!in.is_open())
+        {
+            spillFailed = true;
+            return;
+        }
         vector<string> r;
-        bool in_q = false;
-        string cur = "";
-        for (char ch : line)
+        if (estimate(bytes, rows) > budget && depth <= MAX_SPLIT)
         {
-            if (ch == '"')
-                in_q = !in_q;
-            else if (ch == ',' && !in_q)
+            vector<ofstream> parts;
+            vector<size_t> partBytes(16, 0);
+            vector<long long> partRows(16, 0);
+            bool ok = true;
+            for (int k = 0; k < 16; k++)
             {
-                r.push_back(cur);
-                cur = "";
+                parts.emplace_back(name + "." + to_string(k), ios::binary);
+                ok = ok && parts[k].is_open();
+            }
+            while (ok && read_csv_record(in, r))
+            {
+                int k = (hash64(row_key(r, 1)) >> (4 * (depth - 1))) & 15;
+                string line;
+                CsvWriter::append_row(line, r);
+                ok = !(parts[k] << line).fail();
+                partBytes[k] += line.size();
+                partRows[k]++;
+            }
+            ok = ok && !in.bad();
+            in.close();
+            remove(name.c_str());
+            for (int k = 0; k < 16; k++)
+            {
+                parts[k].close();
+                ok = ok && !parts[k].fail();
+            }
+            for (int k = 0; k < 16; k++)
+            {
+                if (ok)
+                    drain_file(name + "." + to_string(k), partBytes[k], partRows[k], depth + 1, out, chunkRows);
+                else
+                    remove((name + "." + to_string(k)).c_str());
+            }
+            spillFailed = spillFailed || !ok;
+            return;
+        }
+        unordered_set<string> local;
+        StreamChunk chunk;
+        while (read_csv_record(in, r))
+        {
+            long long id = stoll(r[0]);
+            r.erase(r.begin());
+            string key = row_key(r);
+            if (!local.insert(key).second)
+            {
+                dups++;
+                continue;
+            }
+            chunk.ids.push_back(id);
+            chunk.rows.push_back(move(r));
+            emit(chunk, out, chunkRows);
+        }
+        if (!chunk.rows.empty())
+            out.push(move(chunk));
+        if (in.bad())
+            spillFailed = true;
+        in.close();
+        remove(name.c_str());
+    }
+
+public:
+    long long dups;
+
+    StreamDedup(size_t memBudget, string spillPrefix)
+        : used(0), budget(memBudget), prefix(spillPrefix), spilled(0), spillFailed(false), dups(0) {}
+
+    long long spilled_rows() { return spilled; }
+
+    bool failed() const { return spillFailed; }
+
+    // True when the row is new and can be emitted immediately.
+    bool admit(const vector<string> &r, long long id)
+    {
+        string key = row_key(r);
+        if (seen.count(key))
+        {
+            dups++;
+            return false;
+        }
+        if (spill.empty())
+        {
+            used += key.size() + 64;
+            seen.insert(move(key));
+            if (used > budget)
+            {
+                cout << "[stream] dedup memory budget reached, spilling to disk" << endl;
+                for (int p = 0; p < 16; p++)
+                {
+                    spill.emplace_back(prefix + ".spill" + to_string(p), ios::binary);
+                    if (!spill[p].is_open())
+                        spillFailed = true;
+                }
+                spillBytes.assign(16, 0);
+                spillRows.assign(16, 0);
             }
+            return true;
+        }
+        if (spillFailed)
+            return false;
+        size_t p = hash<string>()(key) % spill.size();
+        string line = to_string(id) + ",";
+        CsvWriter::append_row(line, r);
+        if ((spill[p] << line).fail())
+            spillFailed = true;
+        spillBytes[p] += line.size();
+        spillRows[p]++;
+        spilled++;
+        return false;
+    }
+
+    // Spilled rows were never in `seen`, so it is released before the
+    // partitions are read back and only one partition's keys are held at a time.
+    void drain(BoundedQueue<StreamChunk> &out, int chunkRows)
+    {
+        unordered_set<string>().swap(seen);
+        for (int p = 0; p < (int)spill.size(); p++)
+        {
+            spill[p].close();
+            if (spill[p].fail())
+                spillFailed = true;
+        }
+        for (int p = 0; p < (int)spill.size(); p++)
+        {
+            string name = prefix + ".spill" + to_string(p);
+            if (spillFailed)
+                remove(name.c_str());
             else
-                cur += ch;
+                drain_file(name, spillBytes[p], spillRows[p], 1, out, chunkRows);
         }
-        r.push_back(cur);
-        data.push_back(r);
+        spill.clear();
     }
-    file.close();
+};
 
-    int choice = 0;
-    while (choice != 11)
+bool stream_column_means(string fn, vector<double> &means, vector<bool> &has)
+{
+    PrefetchStream in(fn);
+    if (!in.is_open())
+        return false;
+    vector<string> r;
+    read_csv_record(in, r);
+    vector<double> sum(r.size(), 0);
+    vector<long long> cnt(r.size(), 0);
+    while (read_csv_record(in, r))
+        for (int j = 0; j < (int)r.size() && j < (int)sum.size(); j++)
+        {
+            ParsedNum num = parse_number(r[j]);
+            if (num.ok())
+            {
+                sum[j] += num.value;
+                cnt[j]++;
+            }
+        }
+    means.assign(sum.size(), 0);
+    has.assign(sum.size(), false);
+    for (int j = 0; j < (int)sum.size(); j++)
+        if (cnt[j] > 0)
+        {
+            means[j] = sum[j] / cnt[j];
+            has[j] = true;
+        }
+    return !in.error();
+}
+
+// Out-of-core cleaning: read -> drop/impute -> dedup -> score -> write, one
+// thread per stage, connected by bounded queues so memory stays at roughly
+// queueDepth * chunkRows rows per stage regardless of file size.
+bool run_streaming(string fn, const StreamOptions &opt, Trie &dict)
+{
+    PrefetchStream in(fn);
+    if (!in.is_open())
     {
-        cout << "\n--- Smart Data Cleaning Engine ---" << endl;
-        cout << "1. Display Current Data" << endl;
-        cout << "2. Remove Columns" << endl;
-        cout << "3. Handle Duplicates" << endl;
-        cout << "4. Fill Missing Values" << endl;
-        cout << "5. Prioritize Cleaning" << endl;
-        cout << "6. Analyze Column" << endl;
-        cout << "7. Filter Data" << endl;
-        cout << "8. Remove row" << endl;
-        cout << "9. Save data" << endl;
-        cout << "10. Perform Analyics" << endl;
-        cout << "11. EXIT" << endl;
-        cout << "Choice: ";
-        cin >> choice;
+        cout << "Could not open " << fn << endl;
+        return false;
+    }
+    vector<string> head;
+    read_csv_record(in, head);
 
-        switch (choice)
+    vector<int> keep;
+    vector<string> outHead;
+    for (int j = 0; j < (int)head.size(); j++)
+        if (find(opt.dropCols.begin(), opt.dropCols.end(), head[j]) == opt.dropCols.end())
         {
-        case 1:
-            display_data(head, data);
-            break;
-        case 2:
-            remove_column(head, data);
-            break;
-        case 3:
-            handle_duplicates(data);
-            break;
-        case 4:
-            impute_missing(head, data);
-            break;
-        case 5:
-            show_priority_rows(head, data, dict);
-            break;
-        case 6:
-            analyze_column(head, data, dict);
-            break;
-        case 7:
-            filter_data(head, data);
-            break;
-        case 8:
-            remove_row(data);
-            break;
-        case 9:
-            save_data(head, data, "cleaned_data.csv");
-            break;
-        case 10:
-            perform_analytics(head, data);
-            break;
-        case 11:
+            keep.push_back(j);
+            outHead.push_back(head[j]);
+        }
+
+    vector<double> means;
+    vector<bool> hasMean;
+    vector<string> fill(head.size());
+    if (opt.impute)
+    {
+        cout << "[stream] pre-pass: computing column means..." << endl;
+        if (!stream_column_means(fn, means, hasMean))
+        {
+            cout << "Error: Reading " << fn << " failed." << endl;
+            return false;
+        }
+        for (int j = 0; j < (int)head.size() && j < (int)means.size(); j++)
+            if (hasMean[j])
+                fill[j] = format_double(means[j]);
+    }
+
+    unique_ptr<CsvWriter> writer;
+    if (opt.save)
+    {
+        writer.reset(new CsvWriter(opt.output));
+        if (!writer->is_open())
+        {
+            cout << "Error: Could not write to file!" << endl;
+            return false;
+        }
+        writer->write_row(outHead);
+    }
+
+    BoundedQueue<StreamChunk> q_read(opt.queueDepth), q_clean(opt.queueDepth), q_dedup(opt.queueDepth),
+        q_scored(opt.queueDepth);
+    StreamDedup dedup(opt.memBudget, opt.output);
+    long long rowsIn = 0, rowsOut = 0;
+    auto cmp = [](const RowError &a, const RowError &b) { return b < a; };
+    priority_queue<RowError, vector<RowError>, decltype(cmp)> worst(cmp);
+
+    thread reader([&]() {
+        PROF_SCOPE("stream.read");
+        StreamChunk chunk;
+        vector<string> r;
+        while (read_csv_record(in, r))
+        {
+            chunk.ids.push_back(rowsIn++);
+            chunk.rows.push_back(move(r));
+            if ((int)chunk.rows.size() == opt.chunkRows)
+            {
+                q_read.push(move(chunk));
+                chunk = StreamChunk();
+            }
+        }
+        if (!chunk.rows.empty())
+            q_read.push(move(chunk));
+        q_read.close();
+    });
+
+    thread cleaner([&]() {
+        StreamChunk chunk;
+        while (q_read.pop(chunk))
+        {
+            PROF_SCOPE("stream.clean");
+            for (auto &r : chunk.rows)
+            {
+                r.resize(head.size());
+                vector<string> out;
+                out.reserve(keep.size());
+                for (int j : keep)
+                {
+                    if (opt.impute && !fill[j].empty() && (r[j].empty() || r[j] == " "))
+                        out.push_back(fill[j]);
+                    else
+                        out.push_back(move(r[j]));
+                }
+                r = move(out);
+            }
+            q_clean.push(move(chunk));
+        }
+        q_clean.close();
+    });
+
+    thread deduper([&]() {
+        StreamChunk chunk;
+        while (q_clean.pop(chunk))
+        {
+            PROF_SCOPE("stream.dedup");
+            if (opt.dedup)
+            {
+                StreamChunk kept;
+                for (int i = 0; i < (int)chunk.rows.size(); i++)
+                    if (dedup.admit(chunk.rows[i], chunk.ids[i]))
+                    {
+                        kept.ids.push_back(chunk.ids[i]);
+                        kept.rows.push_back(move(chunk.rows[i]));
+                    }
+                chunk = move(kept);
+            }
+            if (!chunk.rows.empty())
+                q_dedup.push(move(chunk));
+        }
+        if (opt.dedup)
+            dedup.drain(q_dedup, opt.chunkRows);
+        q_dedup.close();
+    });
+
+    thread scorer([&]() {
+        StreamChunk chunk;
+        while (q_dedup.pop(chunk))
+        {
+            PROF_SCOPE("stream.score");
+            for (int i = 0; opt.score && i < (int)chunk.rows.size(); i++)
+            {
+                int score = 0;
+                for (const string &cell : chunk.rows[i])
+                {
+                    if (cell.empty() || cell == " ")
+                        score += 2;
+                    else if (!parse_number(cell).ok() && !dict.search(cell))
+                        score += 1;
+                }
+                worst.push({chunk.ids[i], score});
+                if (worst.size() > 5)
+                    worst.pop();
+            }
+            q_scored.push(move(chunk));
+        }
+        q_scored.close();
+    });
+
+    StreamChunk chunk;
+    while (q_scored.pop(chunk))
+    {
+        PROF_SCOPE("stream.write");
+        if (writer)
+            writer->write_rows(chunk.rows);
+        rowsOut += chunk.rows.size();
+    }
+    reader.join();
+    cleaner.join();
+    deduper.join();
+    scorer.join();
+    bool saved = !writer || writer->close();
+    if (in.error())
+    {
+        cout << "Error: Reading " << fn << " failed after " << rowsIn << " rows; " << opt.output
+             << " is incomplete." << endl;
+        return false;
+    }
+    if (dedup.failed())
+    {
+        cout << "Error: Could not write or read back the dedup spill files next to " << opt.output << "; "
+             << opt.output << " is incomplete." << endl;
+        return false;
+    }
+
+    cout << "\n--- Streaming Summary ---" << endl;
+    cout << "Rows read: " << rowsIn << " | Rows " << (writer ? "written: " : "kept: ") << rowsOut << endl;
+    if (opt.dedup)
+        cout << "Duplicates removed: " << dedup.dups << " | Rows spilled to disk: " << dedup.spilled_rows() << endl;
+    if (opt.score)
+    {
+        vector<RowError> top;
+        while (!worst.empty())
+        {
+            top.push_back(worst.top());
+            worst.pop();
+        }
+        cout << "Top Rows Needing Attention:" << endl;
+        for (int i = (int)top.size() - 1; i >= 0; i--)
+            if (top[i].score > 0)
+                cout << "Original Row " << top[i].id << " | Dirty Score: " << top[i].score << endl;
+    }
+    if (!writer)
+        return true;
+    if (!saved)
+    {
+        cout << "Error: Writing " << opt.output << " failed; the file is incomplete." << endl;
+        return false;
+    }
+    cout << "Data successfully saved to " << opt.output << " (" << writer->bytes_written() << " bytes)" << endl;
+    return true;
+}
+
+void streaming_mode(string fn, Trie &dict)
+{
+    StreamOptions opt;
+    cout << "Columns to drop (comma separated names, - for none): ";
+    string cols;
+    cin >> cols;
+    if (cols != "-")
+    {
+        stringstream ss(cols);
+        string c;
+        while (getline(ss, c, ','))
+            opt.dropCols.push_back(c);
+    }
+    cout << "Impute missing numeric values with column mean? (1:Yes, 0:No): ";
+    cin >> opt.impute;
+    cout << "Remove duplicate rows? (1:Yes, 0:No): ";
+    cin >> opt.dedup;
+    run_streaming(fn, opt, dict);
+}
+
+struct PipelineStage
+{
+    string op;
+    string arg;
+};
+
+static string trim(const string &s)
+{
+    size_t b = s.find_first_not_of(" \t\r\n"), e = s.find_last_not_of(" \t\r\n");
+    return b == string::npos ? "" : s.substr(b, e - b + 1);
+}
+
+// Spec grammar: stages separated by ';' or newlines, each "op" or "op=arg";
+// lines starting with '#' are comments. e.g. "drop=Cabin;dedup;impute=mean;save=out.csv"
+vector<PipelineStage> parse_pipeline_spec(string spec)
+{
+    vector<PipelineStage> stages;
+    for (char &c : spec)
+        if (c == '\n')
+            c = ';';
+    stringstream ss(spec);
+    string part;
+    while (getline(ss, part, ';'))
+    {
+        part = trim(part);
+        if (part.empty() || part[0] == '#')
+            continue;
+        size_t eq = part.find('=');
+        stages.push_back({trim(part.substr(0, eq)), eq == string::npos ? "" : trim(part.substr(eq + 1))});
+    }
+    return stages;
+}
+
+// Indexes are taken from the header before anything is erased and removed
+// from the highest down, so each one is still valid when its turn comes. With
+// `cache`, the dropped columns' entries go too and the rest stay cached.
+void drop_columns(vector<string> &head, EncodedTable &data, const vector<string> &names,
+                  ColumnCache *cache = nullptr)
+{
+    for (int j = (int)head.size() - 1; j >= 0; j--)
+        if (find(names.begin(), names.end(), head[j]) != names.end())
+        {
+            head.erase(head.begin() + j);
+            data.erase_column(j);
+            if (cache)
+                cache->erase_column(j);
+        }
+}
+
+static vector<string> split_list(const string &s)
+{
+    vector<string> out;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, ','))
+        if (!trim(item).empty())
+            out.push_back(trim(item));
+    return out;
+}
+
+static bool ends_with(const string &s, const string &suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// "mean", "median" or "mode", optionally grouped: "median:Pclass,Sex".
+bool parse_impute_spec(const string &arg, const vector<string> &head, ImputeSpec &spec)
+{
+    size_t colon = arg.find(':');
+    string name = arg.substr(0, colon);
+    if (name == "" || name == "mean")
+        spec.strategy = IMPUTE_MEAN;
+    else if (name == "median")
+        spec.strategy = IMPUTE_MEDIAN;
+    else if (name == "mode")
+        spec.strategy = IMPUTE_MODE;
+    else
+        return false;
+    if (colon != string::npos)
+        for (const string &col : split_list(arg.substr(colon + 1)))
+        {
+            auto it = find(head.begin(), head.end(), col);
+            if (it == head.end())
+                return false;
+            spec.groupBy.push_back(it - head.begin());
+        }
+    return true;
+}
+
+// Loads a CSV or .dsnap file into an encoded table; false if it cannot be opened
+// or a read fails part way. A snapshot stays mapped and is read in place.
+// With `cache`, it is reset for the new table.
+bool load_table(const string &fn, vector<string> &head, EncodedTable &data, ColumnCache *cache = nullptr)
+{
+    if (ends_with(fn, ".dsnap"))
+    {
+        auto snap = make_shared<SnapshotReader>();
+        if (!snap->open(fn))
+            return false;
+        PROF_SCOPE("load_snapshot");
+        snap->to_table(head, data);
+        if (cache)
+            cache->reset(head.size());
+        return true;
+    }
+    PrefetchStream file(fn);
+    if (!file.is_open())
+        return false;
+    load_csv(file, head, data);
+    if (file.error())
+    {
+        head.clear();
+        data.clear();
+        return false;
+    }
+    if (cache)
+        cache->reset(head.size());
+    return true;
+}
+
+// Checks every stage against the columns it will see (drops are applied to a
+// copy of the header as it goes), so a bad stage fails the run before any
+// stage, and in particular any save, has executed. Row IDs can only be
+// range-checked when the remove stage runs.
+bool validate_pipeline(const vector<PipelineStage> &stages, vector<string> head)
+{
+    for (const PipelineStage &st : stages)
+    {
+        bool ok = true;
+        if (st.op == "drop")
+        {
+            vector<string> names = split_list(st.arg);
+            for (const string &n : names)
+                ok = ok && find(head.begin(), head.end(), n) != head.end();
+            EncodedTable none;
+            drop_columns(head, none, names);
+        }
+        else if (st.op == "impute")
+        {
+            ImputeSpec spec;
+            ok = parse_impute_spec(st.arg, head, spec);
+        }
+        else if (st.op == "remove")
+        {
+            stringstream ss(st.arg);
+            string part;
+            int id, parts = 0;
+            while (ok && getline(ss, part, ','))
+            {
+                if (part.empty())
+                    continue;
+                size_t dash = part.find('-', 1);
+                ok = parse_row_id(part.substr(0, dash), INT_MAX, id) &&
+                     (dash == string::npos || parse_row_id(part.substr(dash + 1), INT_MAX, id));
+                parts++;
+            }
+            ok = ok && parts > 0;
+        }
+        else if (st.op == "groupby")
+        {
+            vector<int> keys;
+            vector<AggSpec> aggs;
+            vector<string> labels;
+            ok = parse_groupby(st.arg, head, keys, aggs, labels);
+        }
+        else if (st.op != "dedup" && st.op != "score" && st.op != "save")
+        {
+            cout << "Unknown pipeline stage: " << st.op << endl;
+            return false;
+        }
+        if (!ok)
+        {
+            cout << "Invalid " << st.op << " stage: " << st.arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Headless mode: loads `fn`, runs the stages in order and prints per-stage timings.
+int run_batch(string fn, const vector<PipelineStage> &stages, Trie &dict)
+{
+    using clk = chrono::steady_clock;
+    vector<pair<string, double>> timings;
+    vector<size_t> rowsAfter;
+    auto t0 = clk::now();
+
+    vector<string> head;
+    EncodedTable data;
+    ColumnCache cache;
+    if (!load_table(fn, head, data, &cache))
+    {
+        cout << "Could not load " << fn << endl;
+        return 1;
+    }
+    timings.push_back({"load", chrono::duration<double, milli>(clk::now() - t0).count()});
+    rowsAfter.push_back(data.size());
+    if (!validate_pipeline(stages, head))
+        return 1;
+
+    for (const PipelineStage &st : stages)
+    {
+        auto start = clk::now();
+        if (st.op == "drop")
+        {
+            drop_columns(head, data, split_list(st.arg), &cache);
+        }
+        else if (st.op == "dedup")
+        {
+            vector<bool> drop;
+            int d = find_duplicates(data, drop);
+            compact_rows(data, drop);
+            cache.remove_rows(drop);
+            cout << "Duplicates removed: " << d << endl;
+        }
+        else if (st.op == "impute")
+        {
+            ImputeSpec spec;
+            if (!parse_impute_spec(st.arg, head, spec))
+            {
+                cout << "Invalid impute stage: " << st.arg << endl;
+                return 1;
+            }
+            impute_missing(head, data, spec, &cache);
+        }
+        else if (st.op == "remove")
+        {
+            vector<bool> drop(data.size(), false);
+            if (data.empty())
+                cout << "Invalid remove stage: " << st.arg << " (the table is empty)" << endl;
+            if (data.empty() || !parse_row_selection(st.arg, data.size(), drop))
+                return 1;
+            compact_rows(data, drop);
+            cache.remove_rows(drop);
+        }
+        else if (st.op == "score")
+        {
+            print_priority_rows(score_rows(head, data, dict));
+        }
+        else if (st.op == "groupby")
+        {
+            if (!run_groupby(head, data, st.arg))
+                return 1;
+        }
+        else if (st.op == "save")
+        {
+            string out = st.arg.empty() ? "cleaned_data.csv" : st.arg;
+            if (!(ends_with(out, ".dsnap") ? save_snapshot(head, data, out) : save_data(head, data, out)))
+                return 1;
+        }
+        else
+        {
+            cout << "Unknown pipeline stage: " << st.op << endl;
+            return 1;
+        }
+        timings.push_back({st.arg.empty() ? st.op : st.op + "=" + st.arg,
+                           chrono::duration<double, milli>(clk::now() - start).count()});
+        rowsAfter.push_back(data.size());
+    }
+
+    double total = 0;
+    cout << "\n--- Pipeline Timings ---" << endl;
+    for (int i = 0; i < (int)timings.size(); i++)
+    {
+        total += timings[i].second;
+        cout << left << setw(24) << timings[i].first.substr(0, 23) << right << setw(12) << fixed << setprecision(3)
+             << timings[i].second << " ms" << setw(12) << rowsAfter[i] << " rows" << endl;
+    }
+    cout << left << setw(24) << "total" << right << setw(12) << total << " ms" << endl;
+    cout.unsetf(ios::fixed);
+    return 0;
+}
+
+int run_batch_stream(string fn, const vector<PipelineStage> &stages, Trie &dict)
+{
+    vector<string> head;
+    {
+        PrefetchStream in(fn);
+        if (!in.is_open() || !read_csv_record(in, head))
+        {
+            cout << "Could not load " << fn << endl;
+            return 1;
+        }
+    }
+    if (!validate_pipeline(stages, head))
+        return 1;
+    // The streaming pipeline runs drop/impute, then dedup, then scoring, then the
+    // write; a spec whose order differs would give different results, so it is rejected.
+    static const map<string, int> RANK = {{"drop", 0}, {"impute", 0}, {"dedup", 1}, {"score", 2}, {"save", 3}};
+    StreamOptions opt;
+    opt.score = false;
+    opt.save = false;
+    int last = 0;
+    string lastOp;
+    for (const PipelineStage &st : stages)
+    {
+        auto rank = RANK.find(st.op);
+        if (rank != RANK.end() && (rank->second < last || last == 3))
+        {
+            cout << "Stage order not supported in streaming mode: " << st.op << " after " << lastOp
+                 << " (streaming runs drop/impute, then dedup, score, save)" << endl;
+            return 1;
+        }
+        if (rank != RANK.end())
+        {
+            last = rank->second;
+            lastOp = st.op;
+        }
+        if (st.op == "drop")
+            for (string c : split_list(st.arg))
+                opt.dropCols.push_back(c);
+        else if (st.op == "dedup")
+            opt.dedup = true;
+        else if (st.op == "impute" && (st.arg == "" || st.arg == "mean"))
+            opt.impute = true;
+        else if (st.op == "save")
+        {
+            opt.save = true;
+            if (!st.arg.empty())
+                opt.output = st.arg;
+        }
+        else if (st.op == "score")
+            opt.score = true;
+        else
+        {
+            cout << "Stage not supported in streaming mode: " << st.op << endl;
+            return 1;
+        }
+    }
+    auto start = chrono::steady_clock::now();
+    bool ok = run_streaming(fn, opt, dict);
+    cout << "Total: " << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms" << endl;
+    return ok ? 0 : 1;
+}
+
+// ---- Server mode ----
+// Tables stay resident between requests. Each table is a chain of immutable
+// versions: readers take a shared_ptr to the current version and never see a
+// later write, and writers copy the rows, edit the copy and publish it as the
+// next version. Indexes are built on first use and kept with their version.
+
+struct ColumnIndex
+{
+    AVLTree ordered;       // value -> row IDs
+    SegmentTree stats;     // over the numeric cells, in row order
+    vector<int> rowOf;     // position in `stats` -> row ID
+
+    ColumnIndex(const vector<double> &vals) : stats(vals) {}
+};
+
+struct TableVersion
+{
+    long version = 1;
+    vector<string> head;
+    EncodedTable data;
+
+    mutable mutex lazyMutex;
+    mutable unordered_map<int, shared_ptr<ColumnIndex>> indexes;
+
+    shared_ptr<ColumnIndex> index(int col) const
+    {
+        lock_guard<mutex> lk(lazyMutex);
+        auto it = indexes.find(col);
+        if (it != indexes.end())
+            return it->second;
+        NumericColumn nc;
+        numeric_cells(data, col, nc);
+        const vector<double> &vals = nc.values;
+        auto idx = make_shared<ColumnIndex>(vals);
+        idx->rowOf = move(nc.rows);
+        for (size_t k = 0; k < vals.size(); k++)
+            idx->ordered.add(vals[k], idx->rowOf[k]);
+        indexes[col] = idx;
+        return idx;
+    }
+};
+
+class TableRegistry
+{
+private:
+    mutex m;
+    map<string, shared_ptr<const TableVersion>> tables;
+    map<string, shared_ptr<mutex>> writeLocks;
+
+public:
+    shared_ptr<const TableVersion> get(const string &name)
+    {
+        lock_guard<mutex> lk(m);
+        auto it = tables.find(name);
+        return it == tables.end() ? nullptr : it->second;
+    }
+
+    // Numbers `v` as the table's next version (1 for a new name) and makes it current.
+    void publish(const string &name, shared_ptr<TableVersion> v)
+    {
+        lock_guard<mutex> lk(m);
+        auto it = tables.find(name);
+        v->version = it == tables.end() ? 1 : it->second->version + 1;
+        tables[name] = v;
+        if (!writeLocks.count(name))
+            writeLocks[name] = make_shared<mutex>();
+    }
+
+    // Serializes writers of one table; readers are never blocked. Null if the
+    // table does not exist, unless `create` is set.
+    shared_ptr<mutex> write_lock(const string &name, bool create = false)
+    {
+        lock_guard<mutex> lk(m);
+        auto it = writeLocks.find(name);
+        if (it != writeLocks.end())
+            return it->second;
+        return create ? writeLocks[name] = make_shared<mutex>() : nullptr;
+    }
+
+    vector<pair<string, shared_ptr<const TableVersion>>> list()
+    {
+        lock_guard<mutex> lk(m);
+        return vector<pair<string, shared_ptr<const TableVersion>>>(tables.begin(), tables.end());
+    }
+};
+
+// Per-command request latencies. Each command keeps its most recent samples;
+// names outside COMMANDS share one "UNKNOWN" entry, so clients cannot grow the log.
+class LatencyLog
+{
+private:
+    static const size_t KEEP = 100000;
+    mutex m;
+    map<string, vector<double>> samples;
+    map<string, long long> counts;
+
+public:
+    static const vector<string> COMMANDS;
+
+    void add(string cmd, double us)
+    {
+        if (find(COMMANDS.begin(), COMMANDS.end(), cmd) == COMMANDS.end())
+            cmd = "UNKNOWN";
+        lock_guard<mutex> lk(m);
+        vector<double> &v = samples[cmd];
+        long long n = counts[cmd]++;
+        if (v.size() < KEEP)
+            v.push_back(us);
+        else
+            v[n % KEEP] = us;
+    }
+
+    string report()
+    {
+        lock_guard<mutex> lk(m);
+        ostringstream out;
+        out << left << setw(10) << "command" << right << setw(10) << "count" << setw(12) << "p50 us" << setw(12)
+            << "p90 us" << setw(12) << "p99 us" << setw(12) << "max us" << "\n";
+        for (auto &kv : samples)
+        {
+            vector<double> v = kv.second;
+            sort(v.begin(), v.end());
+            auto pct = [&](double p) { return v[min(v.size() - 1, (size_t)(p * v.size()))]; };
+            out << left << setw(10) << kv.first << right << setw(10) << counts[kv.first] << fixed
+                << setprecision(1) << setw(12) << pct(0.50) << setw(12) << pct(0.90) << setw(12) << pct(0.99)
+                << setw(12) << v.back() << "\n";
+        }
+        return out.str();
+    }
+};
+
+const vector<string> LatencyLog::COMMANDS = {"HELP", "TABLES", "LOAD", "STATS", "FILTER", "CORR", "SCORE",
+                                             "SPELL", "DEDUP", "IMPUTE", "LATENCY", "QUIT", "SHUTDOWN"};
+
+struct ServerState
+{
+    TableRegistry tables;
+    LatencyLog latency;
+    Trie &dict;
+    LineServer *server;
+
+    ServerState(Trie &d) : dict(d), server(nullptr) {}
+};
+
+static string table_name_of(const string &fn)
+{
+    string base = fn.substr(fn.find_last_of('/') + 1);
+    return base.substr(0, base.find('.'));
+}
+
+static void append_row_text(ostringstream &out, int id, const EncodedTable &data)
+{
+    out << id;
+    for (size_t j = 0; j < data.width(id); j++)
+        out << " | " << data.cell(id, j);
+    out << "\n";
+}
+
+// One request -> response body; throws runtime_error with the reply message on bad input.
+string handle_request(ServerState &st, const vector<string> &a, bool &close)
+{
+    ostringstream out;
+    const string &cmd = a[0];
+    auto need = [&](size_t n) {
+        if (a.size() < n)
+            throw runtime_error("usage: see HELP");
+    };
+    auto table = [&](const string &name) {
+        shared_ptr<const TableVersion> t = st.tables.get(name);
+        if (!t)
+            throw runtime_error("no table " + name);
+        return t;
+    };
+    auto column = [&](const TableVersion &t, const string &name) {
+        int c = resolve_column(t.head, name);
+        if (c < 0)
+            throw runtime_error("no column " + name);
+        return c;
+    };
+    auto number = [&](const string &s) {
+        ParsedNum num = parse_number(s);
+        if (!num.ok())
+            throw runtime_error("not a number: " + s);
+        return num.value;
+    };
+    // Whole numbers in [0, INT_MAX], checked before any cast.
+    auto count = [&](const string &s) {
+        double v = number(s);
+        if (!(v >= 0 && v <= INT_MAX) || v != floor(v))
+            throw runtime_error("not a count: " + s);
+        return (int)v;
+    };
+
+    if (cmd == "HELP")
+    {
+        out << "TABLES | LOAD <name> <file> | STATS <t> <col> [fromRow toRow] | FILTER <t> <col> <min> <max> [limit]\n"
+            << "CORR <t> <colX> <colY> | SCORE <t> [n] | SPELL <word> | DEDUP <t> | IMPUTE <t> <mean|median|mode>\n"
+            << "LATENCY | QUIT | SHUTDOWN\n";
+    }
+    else if (cmd == "TABLES")
+    {
+        for (auto &kv : st.tables.list())
+            out << kv.first << " rows=" << kv.second->data.size() << " cols=" << kv.second->head.size()
+                << " version=" << kv.second->version << "\n";
+    }
+    else if (cmd == "LOAD")
+    {
+        need(3);
+        auto t = make_shared<TableVersion>();
+        if (!load_table(a[2], t->head, t->data))
+            throw runtime_error("could not load " + a[2]);
+        lock_guard<mutex> lk(*st.tables.write_lock(a[1], true));
+        st.tables.publish(a[1], t);
+        out << a[1] << " rows=" << t->data.size() << " version=" << t->version << "\n";
+    }
+    else if (cmd == "STATS")
+    {
+        need(3);
+        if (a.size() == 4)
+            throw runtime_error("STATS takes both fromRow and toRow");
+        auto t = table(a[1]);
+        shared_ptr<ColumnIndex> idx = t->index(column(*t, a[2]));
+        int from = 0, to = (int)t->data.size() - 1;
+        if (a.size() >= 5)
+        {
+            from = count(a[3]);
+            to = count(a[4]);
+        }
+        // Row range -> positions among the numeric cells.
+        int l = lower_bound(idx->rowOf.begin(), idx->rowOf.end(), from) - idx->rowOf.begin();
+        int r = (int)(upper_bound(idx->rowOf.begin(), idx->rowOf.end(), to) - idx->rowOf.begin()) - 1;
+        Node n = idx->stats.query(l, r);
+        int cnt = max(0, r - l + 1);
+        out << "count=" << cnt;
+        if (cnt > 0)
+            out << " sum=" << n.sum << " mean=" << n.sum / cnt << " min=" << n.minVal << " max=" << n.maxVal;
+        out << "\n";
+    }
+    else if (cmd == "FILTER")
+    {
+        need(5);
+        auto t = table(a[1]);
+        shared_ptr<ColumnIndex> idx = t->index(column(*t, a[2]));
+        size_t limit = a.size() >= 6 ? count(a[5]) : 10;
+        vector<int> rows;
+        size_t total = 0;
+        idx->ordered.collect(idx->ordered.root, number(a[3]), number(a[4]), rows, limit, total);
+        out << "matches=" << total << "\n";
+        for (int id : rows)
+            append_row_text(out, id, t->data);
+    }
+    else if (cmd == "CORR")
+    {
+        need(4);
+        auto t = table(a[1]);
+        vector<double> vx, vy;
+        numeric_pairs(t->data, column(*t, a[2]), column(*t, a[3]), vx, vy);
+        out << "r=" << Analytics::calculate_correlation(vx, vy) << " n=" << vx.size() << "\n";
+    }
+    else if (cmd == "SCORE")
+    {
+        need(2);
+        auto t = table(a[1]);
+        int n = a.size() >= 3 ? count(a[2]) : 5;
+        vector<pair<int, int>> scores = score_rows(t->head, t->data, st.dict);
+        for (int i = 0; i < n && i < (int)scores.size() && scores[i].first > 0; i++)
+            out << "row=" << scores[i].second << " score=" << scores[i].first << "\n";
+    }
+    else if (cmd == "SPELL")
+    {
+        need(2);
+        if (st.dict.search(a[1]))
+            out << "ok\n";
+        else
+        {
+            vector<string> sug = st.dict.suggest(a[1].substr(0, 3));
+            out << "unknown";
+            for (size_t i = 0; i < sug.size() && i < 5; i++)
+                out << " " << sug[i];
+            out << "\n";
+        }
+    }
+    else if (cmd == "DEDUP" || cmd == "IMPUTE")
+    {
+        need(cmd == "IMPUTE" ? 3 : 2);
+        ImputeSpec spec;
+        if (cmd == "IMPUTE")
+        {
+            static const char *NAMES[] = {"mean", "median", "mode"};
+            int k = find(NAMES, NAMES + 3, a[2]) - NAMES;
+            if (k == 3)
+                throw runtime_error("strategy must be mean, median or mode");
+            spec.strategy = (ImputeStrategy)k;
+        }
+        shared_ptr<mutex> wl = st.tables.write_lock(a[1]);
+        if (!wl)
+            throw runtime_error("no table " + a[1]);
+        lock_guard<mutex> lk(*wl);
+        auto cur = table(a[1]);
+        auto next = make_shared<TableVersion>();
+        next->head = cur->head;
+        next->data = cur->data;
+        if (cmd == "DEDUP")
+        {
+            vector<bool> drop;
+            int d = find_duplicates(cur->data, drop);
+            compact_rows(next->data, drop);
+            out << "removed=" << d;
+        }
+        else
+        {
+            impute_missing(next->head, next->data, spec);
+            out << "imputed=" << a[2];
+        }
+        st.tables.publish(a[1], next);
+        out << " rows=" << next->data.size() << " version=" << next->version << "\n";
+    }
+    else if (cmd == "LATENCY")
+        out << st.latency.report();
+    else if (cmd == "QUIT")
+        close = true;
+    else if (cmd == "SHUTDOWN")
+    {
+        close = true;
+        st.server->stop();
+    }
+    else
+        throw runtime_error("unknown command " + cmd);
+    return out.str();
+}
+
+// Replies are the response lines followed by "OK" or "ERR <message>".
+int run_server(const vector<string> &inputs, const string &socketPath, Trie &dict)
+{
+    ServerState st(dict);
+    for (const string &fn : inputs)
+    {
+        auto t = make_shared<TableVersion>();
+        if (!load_table(fn, t->head, t->data))
+        {
+            cout << "Could not load " << fn << endl;
+            return 1;
+        }
+        st.tables.publish(table_name_of(fn), t);
+        cout << "Loaded " << table_name_of(fn) << " (" << t->data.size() << " rows)" << endl;
+    }
+    LineServer server(socketPath);
+    if (!server.listen_on())
+    {
+        cout << "Could not listen on " << socketPath << endl;
+        return 1;
+    }
+    st.server = &server;
+    cout << "Serving on " << socketPath << " (send HELP for commands)" << endl;
+    server.run([&](const string &line, bool &close) {
+        auto t0 = chrono::steady_clock::now();
+        vector<string> args;
+        istringstream in(line);
+        for (string w; in >> w;)
+            args.push_back(w);
+        if (args.empty())
+            return string();
+        transform(args[0].begin(), args[0].end(), args[0].begin(), ::toupper);
+        string reply;
+        try
+        {
+            reply = handle_request(st, args, close) + "OK\n";
+        }
+        catch (const exception &e)
+        {
+            reply = string("ERR ") + e.what() + "\n";
+        }
+        st.latency.add(args[0], chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+        return reply;
+    });
+    cout << "Server stopped." << endl;
+    return 0;
+}
+
+void print_usage(const char *prog)
+{
+    cout << "Usage: " << prog << "                                  (interactive menu)" << endl;
+    cout << "       " << prog << " <input> \"<spec>\" [--stream]" << endl;
+    cout << "       " << prog << " <input> --spec-file <file> [--stream]" << endl;
+    cout << "       " << prog << " <input>... --serve <socket path>" << endl;
+    cout << "Add --threads <n> anywhere to size the worker pool (default: DSA_THREADS or all cores)." << endl;
+    cout << "Stages: drop=<col,...>; dedup; impute=<mean|median|mode>[:<col,...>]; remove=<ids>; score; groupby=<keys>:<aggs>; save=<file.csv|file.dsnap>" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    // --threads is accepted in every mode, so strip it before deciding between batch and menu.
+    vector<char *> args(argv, argv + argc);
+    for (size_t i = 1; i < args.size(); i++)
+        if (string(args[i]) == "--threads" && i + 1 < args.size())
+        {
+            ThreadPool::configure(atoi(args[i + 1]));
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            break;
+        }
+    argc = args.size();
+    argv = args.data();
+
+    Trie dict;
+    load_dict(dict, "google-10000-english.txt");
+    if (argc > 1)
+    {
+        string input, spec, servePath;
+        vector<string> inputs;
+        bool stream = false;
+        for (int i = 1; i < argc; i++)
+        {
+            string arg = argv[i];
+            if (arg == "--stream")
+                stream = true;
+            else if (arg == "--serve" && i + 1 < argc)
+                servePath = argv[++i];
+            else if (arg == "--spec-file" && i + 1 < argc)
+            {
+                ifstream sf(argv[++i]);
+                if (!sf.is_open())
+                {
+                    cout << "Could not open spec file " << argv[i] << endl;
+                    return 1;
+                }
+                spec.assign(istreambuf_iterator<char>(sf), istreambuf_iterator<char>());
+            }
+            else if (arg == "--help" || arg == "-h")
+            {
+                print_usage(argv[0]);
+                return 0;
+            }
+            else
+            {
+                inputs.push_back(arg);
+                if (input.empty())
+                    input = arg;
+                else
+                    spec = arg;
+            }
+        }
+        if (input.empty())
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (!servePath.empty())
+            return run_server(inputs, servePath, dict);
+        vector<PipelineStage> stages = parse_pipeline_spec(spec);
+        int rc = stream ? run_batch_stream(input, stages, dict) : run_batch(input, stages, dict);
+        PROF_FINISH();
+        return rc;
+    }
+
+    cout << "Enter the Filename : ";
+    string fn;
+    cin >> fn;
+    vector<string> head;
+    EncodedTable data;
+    ColumnCache cache;
+    if (ends_with(fn, ".dsnap"))
+    {
+        auto snap = make_shared<SnapshotReader>();
+        if (!snap->open(fn))
+        {
+            cout << "Could not open " << fn << endl;
+            return 1;
+        }
+        show_snapshot_stats(*snap);
+        PROF_SCOPE("load_snapshot");
+        snap->to_table(head, data);
+        cache.reset(head.size());
+    }
+    else
+    {
+        cout << "Mode (1: Load into memory, 2: Streaming pipeline for files larger than RAM): ";
+        int mode;
+        cin >> mode;
+        if (mode == 2)
+        {
+            streaming_mode(fn, dict);
+            return 0;
+        }
+        PrefetchStream file(fn);
+        if (!file.is_open())
+        {
+            cout << "Could not open " << fn << endl;
+            return 1;
+        }
+        load_csv(file, head, data);
+        if (file.error())
+        {
+            cout << "Error: Reading " << fn << " failed." << endl;
+            return 1;
+        }
+        cache.reset(head.size());
+    }
+
+    int choice = 0;
+    while (choice != 12)
+    {
+        cout << "\n--- Smart Data Cleaning Engine ---" << endl;
+        cout << "1. Display Current Data" << endl;
+        cout << "2. Remove Columns" << endl;
+        cout << "3. Handle Duplicates" << endl;
+        cout << "4. Fill Missing Values" << endl;
+        cout << "5. Prioritize Cleaning" << endl;
+        cout << "6. Analyze Column" << endl;
+        cout << "7. Filter Data" << endl;
+        cout << "8. Remove row" << endl;
+        cout << "9. Save data" << endl;
+        cout << "10. Perform Analyics" << endl;
+        cout << "11. Group By" << endl;
+        cout << "12. EXIT" << endl;
+        cout << "Choice: ";
+        cin >> choice;
+
+        switch (choice)
+        {
+        case 1:
+            display_data(head, data);
+            break;
+        case 2:
+            remove_column(head, data, cache);
+            break;
+        case 3:
+            handle_duplicates(data, cache);
+            break;
+        case 4:
+            impute_menu(head, data, cache);
+            break;
+        case 5:
+            show_priority_rows(head, data, dict, cache);
+            break;
+        case 6:
+            analyze_column(head, data, dict, cache);
+            break;
+        case 7:
+            filter_data(head, data, cache);
+            break;
+        case 8:
+            remove_row(head, data, cache);
+            break;
+        case 9:
+        {
+            cout << "Format (1: CSV, 2: Binary snapshot): ";
+            int fmt;
+            cin >> fmt;
+            if (fmt == 2)
+                save_snapshot(head, data, "cleaned_data.dsnap");
+            else
+                save_data(head, data, "cleaned_data.csv");
+            break;
+        }
+        case 10:
+            perform_analytics(head, data, cache);
+            break;
+        case 11:
+            groupby_menu(head, data);
+            break;
+        case 12:
             cout << "Exiting program. Goodbye!" << endl;
+            PROF_FINISH();
             return 0;
         default:
-            cout << "Invalid choice! Please enter 1-11." << endl;
+            cout << "Invalid choice! Please enter 1-12." << endl;
         }
     }
     return 0;
@@ -5,6 +5,7 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include "Arena.h"
 
 using namespace std;
 
@@ -25,19 +26,9 @@ struct TrieNode
 class Trie
 {
 private:
+    Arena pool;
     TrieNode *root;
 
-    void deleteTrie(TrieNode *node)
-    {
-        if (!node)
-            return;
-        for (int i = 0; i < 26; i++)
-        {
-            deleteTrie(node->children[i]);
-        }
-        delete node;
-    }
-
     void findWords(TrieNode *node, string currentPrefix, vector<string> &results)
     {
         if (node->isEndOfWord)
@@ -65,15 +56,13 @@ private:
     }
 
 public:
-    Trie()
+    Trie() : pool(1 << 16)
     {
-        root = new TrieNode();
+        root = pool.create<TrieNode>();
     }
 
-    ~Trie()
-    {
-        deleteTrie(root);
-    }
+    Trie(const Trie &) = delete;
+    Trie &operator=(const Trie &) = delete;
 
     void insert(string word)
     {
@@ -86,7 +75,7 @@ public:
 
             if (!crawler->children[index])
             {
-                crawler->children[index] = new TrieNode();
+                crawler->children[index] = pool.create<TrieNode>();
             }
             crawler = crawler->children[index];
         }
@@ -131,6 +120,8 @@ public:
         findWords(crawler, prefix, suggestions);
         return suggestions;
     }
+
+    ArenaStats memory_stats() { return pool.stats(); }
 };
 
 #endif
\ No newline at end of file